@@ -0,0 +1,960 @@
+#include <hubDB/DBARTIndex.h>
+#include <hubDB/DBException.h>
+
+using namespace HubDB::Index;
+using namespace HubDB::Exception;
+
+LoggerPtr DBARTIndex::logger(Logger::getLogger("HubDB.Index.DBARTIndex"));
+
+// registerClass()-Methode am Ende dieser Datei: macht die Klasse der Factory bekannt
+int rARTIdx = DBARTIndex::registerClass();
+const BlockNo DBARTIndex::metaBlockNo(0);
+const uint DBARTIndex::maxPrefixLen;
+extern "C" void * createDBARTIndex(int nArgs, va_list ap);
+
+/**
+ * Blaetter werden als getaggte Zeiger (niedrigstes Bit gesetzt) zwischen den
+ * Kindzeigern abgelegt
+ */
+#define IS_LEAF(x) (((size_t) (x)) & 1)
+#define SET_LEAF(x) ((artNode *) (((size_t) (x)) | 1))
+#define LEAF_RAW(x) ((artLeaf *) (((size_t) (x)) & ~((size_t) 1)))
+
+/**
+ * Layout Snapshot:
+ * - Metablock:  | uint entryCnt | uint keyLen | uint logPages |
+ * - ab Block 1: | uint cnt | (normalisierter key, TID) * cnt |, aufsteigend sortiert
+ * - direkt hinter dem Snapshot logPages Log-Seiten: | uint cnt | (normalisierter key, TID, char tomb) * cnt |
+ */
+
+DBARTIndex::DBARTIndex(DBBufferMgr &bufferMgr, DBFile &file, enum AttrTypeEnum attrType, ModType mode, bool unique)
+        : DBIndex(bufferMgr, file, attrType, mode, unique), root(NULL), keyLen(attrTypeSize), entryCnt(0), modified(false), logTailCnt(0) {
+    if (logger != NULL) {
+        LOG4CXX_INFO(logger,"DBARTIndex()");
+    }
+
+    if (bufMgr.getBlockCnt(file) == 0) {
+        LOG4CXX_DEBUG(logger,"initializeIndex");
+        initializeIndex();
+    }
+
+    //fix meta block
+    bacbStack.push(bufMgr.fixBlock(file, metaBlockNo, mode == READ ? LOCK_SHARED : LOCK_INTWRITE));
+    load();
+
+    if (logger != NULL) {
+        LOG4CXX_DEBUG(logger,"this:\n"+toString("\t"));
+    }
+}
+
+DBARTIndex::~DBARTIndex() {
+    LOG4CXX_INFO(logger,"~DBARTIndex()");
+    //Aenderungen stehen im Log, der Snapshot beim Schliessen kuerzt nur das Log
+    if (modified && bacbStack.size() == 1 && bacbStack.top().getLockMode() != LOCK_SHARED) {
+        try {
+            snapshot();
+        } catch (DBException & e) {
+            LOG4CXX_ERROR(logger,"could not write snapshot on close");
+        }
+    }
+    destroyRec(root);
+    unfixBACBs(false);
+}
+
+string DBARTIndex::toString(string linePrefix) const {
+    stringstream ss;
+    ss << DBIndex::toString(linePrefix);
+    ss << linePrefix << "entries: " << entryCnt << "\n";
+    return ss.str();
+}
+
+void DBARTIndex::initializeIndex() {
+    LOG4CXX_INFO(logger,"initializeIndex()");
+    if (bufMgr.getBlockCnt(file) != 0)
+        throw DBIndexException("Can not initialize existing table");
+
+    try {
+        bacbStack.push(bufMgr.fixNewBlock(file));
+        bacbStack.top().setModified();
+        uint * metaPtr = (uint *) bacbStack.top().getDataPtr();
+        metaPtr[0] = 0;
+        metaPtr[1] = keyLen;
+        metaPtr[2] = 0;
+    } catch (DBException & e) {
+        if (bacbStack.empty() == false)
+            bufMgr.unfixBlock(bacbStack.top());
+        throw e;
+    }
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+
+    // nun muss die liste der geblockten Seiten wieder leer sein, sonst Abbruch
+    assert(bacbStack.empty()==true);
+}
+
+/**
+ * Normalisierung: Byteweiser Vergleich der Schluessel entspricht der Ordnung der Werte
+ * - INT: Big Endian, Vorzeichenbit invertiert
+ * - DOUBLE: Big Endian, bei negativen Werten alle Bits, sonst nur das Vorzeichenbit invertiert
+ * - VCHAR: Zeichen mit Nullen aufgefuellt
+ */
+void DBARTIndex::normalizeKey(const DBAttrType & val, unsigned char * key) const {
+    memset(key, 0, keyLen);
+    val.write((char *) key);
+    if (attrType == INT) {
+        int v;
+        memcpy(&v, key, sizeof(int));
+        uint u = ((uint) v) ^ 0x80000000u;
+        for (uint i = 0; i < sizeof(int); ++i)
+            key[i] = (unsigned char) (u >> (8 * (sizeof(int) - 1 - i)));
+    } else if (attrType == DOUBLE) {
+        unsigned long long u;
+        memcpy(&u, key, sizeof(double));
+        const unsigned long long signBit = 1ULL << 63;
+        u = (u & signBit) ? ~u : (u ^ signBit);
+        for (uint i = 0; i < sizeof(double); ++i)
+            key[i] = (unsigned char) (u >> (8 * (sizeof(double) - 1 - i)));
+    }
+}
+
+DBARTIndex::artLeaf * DBARTIndex::makeLeaf(const unsigned char * key, const TID & tid) {
+    artLeaf * l = (artLeaf *) new char[sizeof(artLeaf) + keyLen];
+    l->tid = tid;
+    memcpy(l->key, key, keyLen);
+    return l;
+}
+
+DBARTIndex::artLeaf * DBARTIndex::minimum(artNode * n) const {
+    while (n != NULL && !IS_LEAF(n)) {
+        switch (n->type) {
+            case NODE4: n = ((artNode4 *) n)->children[0]; break;
+            case NODE16: n = ((artNode16 *) n)->children[0]; break;
+            case NODE48: {
+                artNode48 * n48 = (artNode48 *) n;
+                uint i = 0;
+                while (n48->childIndex[i] == 0) i++;
+                n = n48->children[n48->childIndex[i] - 1];
+                break;
+            }
+            default: {
+                artNode256 * n256 = (artNode256 *) n;
+                uint i = 0;
+                while (n256->children[i] == NULL) i++;
+                n = n256->children[i];
+            }
+        }
+    }
+    return n == NULL ? NULL : LEAF_RAW(n);
+}
+
+DBARTIndex::artLeaf * DBARTIndex::maximum(artNode * n) const {
+    while (n != NULL && !IS_LEAF(n)) {
+        switch (n->type) {
+            case NODE4: n = ((artNode4 *) n)->children[n->numChildren - 1]; break;
+            case NODE16: n = ((artNode16 *) n)->children[n->numChildren - 1]; break;
+            case NODE48: {
+                artNode48 * n48 = (artNode48 *) n;
+                uint i = 255;
+                while (n48->childIndex[i] == 0) i--;
+                n = n48->children[n48->childIndex[i] - 1];
+                break;
+            }
+            default: {
+                artNode256 * n256 = (artNode256 *) n;
+                uint i = 255;
+                while (n256->children[i] == NULL) i--;
+                n = n256->children[i];
+            }
+        }
+    }
+    return n == NULL ? NULL : LEAF_RAW(n);
+}
+
+DBARTIndex::artNode ** DBARTIndex::findChild(artNode * n, unsigned char c) const {
+    switch (n->type) {
+        case NODE4: {
+            artNode4 * n4 = (artNode4 *) n;
+            for (uint i = 0; i < n->numChildren; ++i)
+                if (n4->keys[i] == c)
+                    return &n4->children[i];
+            break;
+        }
+        case NODE16: {
+            artNode16 * n16 = (artNode16 *) n;
+            for (uint i = 0; i < n->numChildren; ++i)
+                if (n16->keys[i] == c)
+                    return &n16->children[i];
+            break;
+        }
+        case NODE48: {
+            artNode48 * n48 = (artNode48 *) n;
+            if (n48->childIndex[c] != 0)
+                return &n48->children[n48->childIndex[c] - 1];
+            break;
+        }
+        default: {
+            artNode256 * n256 = (artNode256 *) n;
+            if (n256->children[c] != NULL)
+                return &n256->children[c];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Anzahl uebereinstimmender Bytes im (gespeicherten Teil des) Praefixes.
+ * Praefixe laenger als maxPrefixLen werden optimistisch uebersprungen und am Blatt geprueft.
+ */
+uint DBARTIndex::checkPrefix(const artNode * n, const unsigned char * key, uint depth) const {
+    uint maxCmp = min(min(n->prefixLen, maxPrefixLen), keyLen - depth);
+    uint idx = 0;
+    for (; idx < maxCmp; ++idx) {
+        if (n->prefix[idx] != key[depth + idx])
+            return idx;
+    }
+    return idx;
+}
+
+/**
+ * Wie checkPrefix, vergleicht ueber maxPrefixLen hinaus aber mit dem kleinsten Blatt
+ */
+uint DBARTIndex::prefixMismatch(artNode * n, const unsigned char * key, uint depth) const {
+    uint maxCmp = min(min(n->prefixLen, maxPrefixLen), keyLen - depth);
+    uint idx = 0;
+    for (; idx < maxCmp; ++idx) {
+        if (n->prefix[idx] != key[depth + idx])
+            return idx;
+    }
+    if (n->prefixLen > maxPrefixLen) {
+        artLeaf * l = minimum(n);
+        maxCmp = min(n->prefixLen, keyLen - depth);
+        for (; idx < maxCmp; ++idx) {
+            if (l->key[depth + idx] != key[depth + idx])
+                return idx;
+        }
+    }
+    return idx;
+}
+
+void DBARTIndex::addChild(artNode * n, artNode ** ref, unsigned char c, artNode * child) {
+    switch (n->type) {
+        case NODE4: {
+            artNode4 * n4 = (artNode4 *) n;
+            if (n->numChildren < 4) {
+                uint idx = 0;
+                while (idx < n->numChildren && c > n4->keys[idx]) idx++;
+                memmove(n4->keys + idx + 1, n4->keys + idx, n->numChildren - idx);
+                memmove(n4->children + idx + 1, n4->children + idx, (n->numChildren - idx) * sizeof(artNode *));
+                n4->keys[idx] = c;
+                n4->children[idx] = child;
+                n->numChildren++;
+                return;
+            }
+            artNode16 * n16 = new artNode16();
+            *(artNode *) n16 = *n;
+            n16->type = NODE16;
+            memcpy(n16->keys, n4->keys, 4);
+            memcpy(n16->children, n4->children, 4 * sizeof(artNode *));
+            *ref = n16;
+            delete n4;
+            addChild(n16, ref, c, child);
+            return;
+        }
+        case NODE16: {
+            artNode16 * n16 = (artNode16 *) n;
+            if (n->numChildren < 16) {
+                uint idx = 0;
+                while (idx < n->numChildren && c > n16->keys[idx]) idx++;
+                memmove(n16->keys + idx + 1, n16->keys + idx, n->numChildren - idx);
+                memmove(n16->children + idx + 1, n16->children + idx, (n->numChildren - idx) * sizeof(artNode *));
+                n16->keys[idx] = c;
+                n16->children[idx] = child;
+                n->numChildren++;
+                return;
+            }
+            artNode48 * n48 = new artNode48();
+            *(artNode *) n48 = *n;
+            n48->type = NODE48;
+            for (uint i = 0; i < 16; ++i) {
+                n48->children[i] = n16->children[i];
+                n48->childIndex[n16->keys[i]] = i + 1;
+            }
+            *ref = n48;
+            delete n16;
+            addChild(n48, ref, c, child);
+            return;
+        }
+        case NODE48: {
+            artNode48 * n48 = (artNode48 *) n;
+            if (n->numChildren < 48) {
+                uint pos = 0;
+                while (n48->children[pos] != NULL) pos++;
+                n48->children[pos] = child;
+                n48->childIndex[c] = pos + 1;
+                n->numChildren++;
+                return;
+            }
+            artNode256 * n256 = new artNode256();
+            *(artNode *) n256 = *n;
+            n256->type = NODE256;
+            for (uint i = 0; i < 256; ++i) {
+                if (n48->childIndex[i] != 0)
+                    n256->children[i] = n48->children[n48->childIndex[i] - 1];
+            }
+            *ref = n256;
+            delete n48;
+            addChild(n256, ref, c, child);
+            return;
+        }
+        default: {
+            artNode256 * n256 = (artNode256 *) n;
+            n256->children[c] = child;
+            n->numChildren++;
+        }
+    }
+}
+
+void DBARTIndex::removeChild(artNode * n, artNode ** ref, unsigned char c, artNode ** child) {
+    switch (n->type) {
+        case NODE4: {
+            artNode4 * n4 = (artNode4 *) n;
+            uint pos = child - n4->children;
+            memmove(n4->keys + pos, n4->keys + pos + 1, n->numChildren - pos - 1);
+            memmove(n4->children + pos, n4->children + pos + 1, (n->numChildren - pos - 1) * sizeof(artNode *));
+            n->numChildren--;
+            if (n->numChildren == 1) {
+                //Knoten mit nur einem Kind entfernen, Praefixe zusammenfassen
+                artNode * only = n4->children[0];
+                if (!IS_LEAF(only)) {
+                    uint prefix = n->prefixLen;
+                    if (prefix < maxPrefixLen) {
+                        n->prefix[prefix] = n4->keys[0];
+                        prefix++;
+                    }
+                    if (prefix < maxPrefixLen) {
+                        uint subPrefix = min(only->prefixLen, maxPrefixLen - prefix);
+                        memcpy(n->prefix + prefix, only->prefix, subPrefix);
+                        prefix += subPrefix;
+                    }
+                    memcpy(only->prefix, n->prefix, min(prefix, maxPrefixLen));
+                    only->prefixLen += n->prefixLen + 1;
+                }
+                *ref = only;
+                delete n4;
+            }
+            return;
+        }
+        case NODE16: {
+            artNode16 * n16 = (artNode16 *) n;
+            uint pos = child - n16->children;
+            memmove(n16->keys + pos, n16->keys + pos + 1, n->numChildren - pos - 1);
+            memmove(n16->children + pos, n16->children + pos + 1, (n->numChildren - pos - 1) * sizeof(artNode *));
+            n->numChildren--;
+            if (n->numChildren == 3) {
+                artNode4 * n4 = new artNode4();
+                *(artNode *) n4 = *n;
+                n4->type = NODE4;
+                memcpy(n4->keys, n16->keys, 3);
+                memcpy(n4->children, n16->children, 3 * sizeof(artNode *));
+                *ref = n4;
+                delete n16;
+            }
+            return;
+        }
+        case NODE48: {
+            artNode48 * n48 = (artNode48 *) n;
+            uint pos = n48->childIndex[c];
+            n48->childIndex[c] = 0;
+            n48->children[pos - 1] = NULL;
+            n->numChildren--;
+            if (n->numChildren == 12) {
+                artNode16 * n16 = new artNode16();
+                *(artNode *) n16 = *n;
+                n16->type = NODE16;
+                uint idx = 0;
+                for (uint i = 0; i < 256; ++i) {
+                    if (n48->childIndex[i] != 0) {
+                        n16->keys[idx] = i;
+                        n16->children[idx] = n48->children[n48->childIndex[i] - 1];
+                        idx++;
+                    }
+                }
+                *ref = n16;
+                delete n48;
+            }
+            return;
+        }
+        default: {
+            artNode256 * n256 = (artNode256 *) n;
+            n256->children[c] = NULL;
+            n->numChildren--;
+            if (n->numChildren == 37) {
+                artNode48 * n48 = new artNode48();
+                *(artNode *) n48 = *n;
+                n48->type = NODE48;
+                uint pos = 0;
+                for (uint i = 0; i < 256; ++i) {
+                    if (n256->children[i] != NULL) {
+                        n48->children[pos] = n256->children[i];
+                        n48->childIndex[i] = pos + 1;
+                        pos++;
+                    }
+                }
+                *ref = n48;
+                delete n256;
+            }
+        }
+    }
+}
+
+/**
+ * Rueckgabe false, wenn der Schluessel bereits existiert
+ */
+bool DBARTIndex::insertRec(artNode * n, artNode ** ref, const unsigned char * key, uint depth, const TID & tid) {
+    if (n == NULL) {
+        *ref = SET_LEAF(makeLeaf(key, tid));
+        return true;
+    }
+
+    if (IS_LEAF(n)) {
+        artLeaf * l = LEAF_RAW(n);
+        if (memcmp(l->key, key, keyLen) == 0)
+            return false;
+
+        //Blatt durch Node4 mit gemeinsamem Praefix ersetzen
+        artNode4 * n4 = new artNode4();
+        n4->type = NODE4;
+        uint prefix = depth;
+        while (prefix < keyLen && l->key[prefix] == key[prefix]) prefix++;
+        n4->prefixLen = prefix - depth;
+        memcpy(n4->prefix, key + depth, min(n4->prefixLen, maxPrefixLen));
+        *ref = n4;
+        addChild(n4, ref, l->key[prefix], n);
+        addChild(n4, ref, key[prefix], SET_LEAF(makeLeaf(key, tid)));
+        return true;
+    }
+
+    if (n->prefixLen > 0) {
+        uint prefixDiff = prefixMismatch(n, key, depth);
+        if (prefixDiff < n->prefixLen) {
+            //Praefix aufspalten
+            artNode4 * n4 = new artNode4();
+            n4->type = NODE4;
+            n4->prefixLen = prefixDiff;
+            memcpy(n4->prefix, n->prefix, min(prefixDiff, maxPrefixLen));
+            *ref = n4;
+            if (n->prefixLen <= maxPrefixLen) {
+                addChild(n4, ref, n->prefix[prefixDiff], n);
+                n->prefixLen -= prefixDiff + 1;
+                memmove(n->prefix, n->prefix + prefixDiff + 1, min(n->prefixLen, maxPrefixLen));
+            } else {
+                n->prefixLen -= prefixDiff + 1;
+                artLeaf * l = minimum(n);
+                addChild(n4, ref, l->key[depth + prefixDiff], n);
+                memcpy(n->prefix, l->key + depth + prefixDiff + 1, min(n->prefixLen, maxPrefixLen));
+            }
+            addChild(n4, ref, key[depth + prefixDiff], SET_LEAF(makeLeaf(key, tid)));
+            return true;
+        }
+        depth += n->prefixLen;
+    }
+
+    artNode ** child = findChild(n, key[depth]);
+    if (child != NULL)
+        return insertRec(*child, child, key, depth + 1, tid);
+
+    addChild(n, ref, key[depth], SET_LEAF(makeLeaf(key, tid)));
+    return true;
+}
+
+DBARTIndex::artLeaf * DBARTIndex::removeRec(artNode * n, artNode ** ref, const unsigned char * key, uint depth) {
+    if (n == NULL)
+        return NULL;
+
+    if (IS_LEAF(n)) {
+        artLeaf * l = LEAF_RAW(n);
+        if (memcmp(l->key, key, keyLen) != 0)
+            return NULL;
+        *ref = NULL;
+        return l;
+    }
+
+    if (n->prefixLen > 0) {
+        if (checkPrefix(n, key, depth) != min(n->prefixLen, maxPrefixLen))
+            return NULL;
+        depth += n->prefixLen;
+    }
+
+    artNode ** child = findChild(n, key[depth]);
+    if (child == NULL)
+        return NULL;
+
+    if (IS_LEAF(*child)) {
+        artLeaf * l = LEAF_RAW(*child);
+        if (memcmp(l->key, key, keyLen) != 0)
+            return NULL;
+        removeChild(n, ref, key[depth], child);
+        return l;
+    }
+    return removeRec(*child, child, key, depth + 1);
+}
+
+/**
+ * Kinder von n und ihre Schluesselbytes in aufsteigender Reihenfolge, Rueckgabe Anzahl
+ */
+uint DBARTIndex::orderedChildren(artNode * n, unsigned char * keys, artNode ** children) const {
+    uint cnt = 0;
+    switch (n->type) {
+        case NODE4:
+            memcpy(keys, ((artNode4 *) n)->keys, n->numChildren);
+            memcpy(children, ((artNode4 *) n)->children, n->numChildren * sizeof(artNode *));
+            cnt = n->numChildren;
+            break;
+        case NODE16:
+            memcpy(keys, ((artNode16 *) n)->keys, n->numChildren);
+            memcpy(children, ((artNode16 *) n)->children, n->numChildren * sizeof(artNode *));
+            cnt = n->numChildren;
+            break;
+        case NODE48: {
+            artNode48 * n48 = (artNode48 *) n;
+            for (uint i = 0; i < 256; ++i) {
+                if (n48->childIndex[i] != 0) {
+                    keys[cnt] = i;
+                    children[cnt++] = n48->children[n48->childIndex[i] - 1];
+                }
+            }
+            break;
+        }
+        default: {
+            artNode256 * n256 = (artNode256 *) n;
+            for (uint i = 0; i < 256; ++i) {
+                if (n256->children[i] != NULL) {
+                    keys[cnt] = i;
+                    children[cnt++] = n256->children[i];
+                }
+            }
+        }
+    }
+    return cnt;
+}
+
+/**
+ * Ein Abstieg entlang lo bis zur unteren Grenze (onLowerPath), ab dort werden
+ * die Teilbaeume in Schluesselreihenfolge ohne weitere Vergleiche durchlaufen,
+ * bis das erste Blatt groesser als hi ist
+ */
+void DBARTIndex::rangeRec(artNode * n, uint depth, bool onLowerPath, const unsigned char * lo, const unsigned char * hi, DBListTID & tids, bool & done) const {
+    if (IS_LEAF(n)) {
+        artLeaf * l = LEAF_RAW(n);
+        if (memcmp(l->key, hi, keyLen) > 0) {
+            done = true;
+        } else if (onLowerPath == false || memcmp(l->key, lo, keyLen) >= 0) {
+            tids.push_back(l->tid);
+        }
+        return;
+    }
+
+    if (onLowerPath && n->prefixLen > 0) {
+        //ueber maxPrefixLen hinaus steht das Praefix nur in den Blaettern
+        const unsigned char * prefix = n->prefixLen > maxPrefixLen ? minimum(n)->key + depth : n->prefix;
+        int cmp = memcmp(prefix, lo + depth, n->prefixLen);
+        if (cmp < 0)
+            return;
+        if (cmp > 0)
+            onLowerPath = false;
+    }
+    depth += n->prefixLen;
+
+    unsigned char keys[256];
+    artNode * children[256];
+    uint cnt = orderedChildren(n, keys, children);
+    for (uint i = 0; i < cnt && done == false; ++i) {
+        if (onLowerPath && keys[i] < lo[depth])
+            continue;
+        rangeRec(children[i], depth + 1, onLowerPath && keys[i] == lo[depth], lo, hi, tids, done);
+    }
+}
+
+void DBARTIndex::collectLeaves(artNode * n, vector<artLeaf *> & leaves) const {
+    if (n == NULL)
+        return;
+    if (IS_LEAF(n)) {
+        leaves.push_back(LEAF_RAW(n));
+        return;
+    }
+    switch (n->type) {
+        case NODE4:
+            for (uint i = 0; i < n->numChildren; ++i)
+                collectLeaves(((artNode4 *) n)->children[i], leaves);
+            break;
+        case NODE16:
+            for (uint i = 0; i < n->numChildren; ++i)
+                collectLeaves(((artNode16 *) n)->children[i], leaves);
+            break;
+        case NODE48: {
+            artNode48 * n48 = (artNode48 *) n;
+            for (uint i = 0; i < 256; ++i)
+                if (n48->childIndex[i] != 0)
+                    collectLeaves(n48->children[n48->childIndex[i] - 1], leaves);
+            break;
+        }
+        default: {
+            artNode256 * n256 = (artNode256 *) n;
+            for (uint i = 0; i < 256; ++i)
+                if (n256->children[i] != NULL)
+                    collectLeaves(n256->children[i], leaves);
+        }
+    }
+}
+
+void DBARTIndex::destroyRec(artNode * n) {
+    if (n == NULL)
+        return;
+    if (IS_LEAF(n)) {
+        delete[] (char *) LEAF_RAW(n);
+        return;
+    }
+    switch (n->type) {
+        case NODE4:
+            for (uint i = 0; i < n->numChildren; ++i)
+                destroyRec(((artNode4 *) n)->children[i]);
+            delete (artNode4 *) n;
+            break;
+        case NODE16:
+            for (uint i = 0; i < n->numChildren; ++i)
+                destroyRec(((artNode16 *) n)->children[i]);
+            delete (artNode16 *) n;
+            break;
+        case NODE48: {
+            artNode48 * n48 = (artNode48 *) n;
+            for (uint i = 0; i < 256; ++i)
+                if (n48->childIndex[i] != 0)
+                    destroyRec(n48->children[n48->childIndex[i] - 1]);
+            delete n48;
+            break;
+        }
+        default: {
+            artNode256 * n256 = (artNode256 *) n;
+            for (uint i = 0; i < 256; ++i)
+                destroyRec(n256->children[i]);
+            delete n256;
+        }
+    }
+}
+
+void DBARTIndex::find(const DBAttrType &val, DBListTID &tids) {
+    LOG4CXX_INFO(logger,"find()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+
+    tids.clear();
+
+    unsigned char * key = new unsigned char[keyLen];
+    normalizeKey(val, key);
+
+    artNode * n = root;
+    uint depth = 0;
+    while (n != NULL) {
+        if (IS_LEAF(n)) {
+            artLeaf * l = LEAF_RAW(n);
+            if (memcmp(l->key, key, keyLen) == 0) {
+                LOG4CXX_DEBUG(logger,"Found TID: "+l->tid.toString());
+                tids.push_back(l->tid);
+            }
+            break;
+        }
+        if (n->prefixLen > 0) {
+            if (checkPrefix(n, key, depth) != min(n->prefixLen, maxPrefixLen))
+                break;
+            depth += n->prefixLen;
+        }
+        artNode ** child = findChild(n, key[depth]);
+        n = child == NULL ? NULL : *child;
+        depth++;
+    }
+    delete[] key;
+}
+
+void DBARTIndex::findRange(const DBAttrType &lo, const DBAttrType &hi, DBListTID &tids) {
+    LOG4CXX_INFO(logger,"findRange()");
+    LOG4CXX_DEBUG(logger,"lo:\n"+lo.toString("\t"));
+    LOG4CXX_DEBUG(logger,"hi:\n"+hi.toString("\t"));
+
+    tids.clear();
+    if (root == NULL)
+        return;
+
+    unsigned char * loKey = new unsigned char[keyLen];
+    unsigned char * hiKey = new unsigned char[keyLen];
+    normalizeKey(lo, loKey);
+    normalizeKey(hi, hiKey);
+    bool done = false;
+    if (memcmp(loKey, hiKey, keyLen) <= 0)
+        rangeRec(root, 0, true, loKey, hiKey, tids, done);
+    delete[] loKey;
+    delete[] hiKey;
+}
+
+void DBARTIndex::insert(const DBAttrType &val, const TID &tid) {
+    LOG4CXX_INFO(logger,"insert()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+    LOG4CXX_DEBUG(logger,"tid: "+tid.toString());
+
+    unsigned char * key = new unsigned char[keyLen];
+    normalizeKey(val, key);
+    bool inserted = insertRec(root, &root, key, 0, tid);
+    if (inserted == false) {
+        delete[] key;
+        throw DBIndexException("Insert failed, entry already exists with key "+val.toString());
+    }
+    entryCnt++;
+    modified = true;
+    try {
+        appendToLog(key, tid, false);
+    } catch (DBException & e) {
+        delete[] key;
+        throw e;
+    }
+    delete[] key;
+}
+
+void DBARTIndex::remove(const DBAttrType &val, const DBListTID &tid) {
+    LOG4CXX_INFO(logger,"remove()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+
+    //index is unique, no multiple TIDs
+    if (tid.size() > 1)
+        throw DBIndexException("Unique Index Only, no multiple TID delete");
+
+    DBListTID existing;
+    find(val, existing);
+    if (existing.empty() || tid.empty() || !(existing.front() == tid.front())) {
+        LOG4CXX_DEBUG(logger,"Given value not found to delete");
+        return;
+    }
+
+    unsigned char * key = new unsigned char[keyLen];
+    normalizeKey(val, key);
+    artLeaf * l = removeRec(root, &root, key, 0);
+    if (l != NULL) {
+        delete[] (char *) l;
+        entryCnt--;
+        modified = true;
+        try {
+            appendToLog(key, tid.front(), true);
+        } catch (DBException & e) {
+            delete[] key;
+            throw e;
+        }
+    }
+    delete[] key;
+}
+
+/**
+ * Schreibt alle Eintraege sortiert ab Block 1 in die Datei
+ */
+void DBARTIndex::snapshot() {
+    LOG4CXX_INFO(logger,"snapshot()");
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+
+    vector<artLeaf *> leaves;
+    collectLeaves(root, leaves);
+
+    //alte Snapshot- und Log-Seiten werden ueberschrieben, das Log ist danach leer
+    const uint entrySize = keyLen + sizeof(TID);
+    BlockNo b = metaBlockNo + 1;
+    for (uint i = 0; i < leaves.size(); b++) {
+        if (b < bufMgr.getBlockCnt(file))
+            bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+        else
+            bacbStack.push(bufMgr.fixNewBlock(file));
+        char * ptr = bacbStack.top().getDataPtr();
+        uint * cnt = (uint *) ptr;
+        ptr += sizeof(uint);
+        for (*cnt = 0; *cnt < entriesPerPage() && i < leaves.size(); ++*cnt, ++i) {
+            memcpy(ptr, leaves[i]->key, keyLen);
+            memcpy(ptr + keyLen, &leaves[i]->tid, sizeof(TID));
+            ptr += entrySize;
+        }
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+    }
+
+    uint * metaPtr = (uint *) bacbStack.top().getDataPtr();
+    metaPtr[0] = leaves.size();
+    metaPtr[1] = keyLen;
+    metaPtr[2] = 0;
+    bacbStack.top().setModified();
+    modified = false;
+    logTailCnt = 0;
+    LOG4CXX_DEBUG(logger,"Snapshot entries: "+TO_STR(leaves.size())+", pages: "+TO_STR(b - metaBlockNo - 1));
+}
+
+void DBARTIndex::load() {
+    LOG4CXX_INFO(logger,"load()");
+    const uint * metaPtr = (const uint *) bacbStack.top().getDataPtr();
+    uint cnt = metaPtr[0];
+    if (cnt > 0 && metaPtr[1] != keyLen)
+        throw DBIndexException("Snapshot key length does not match attribute type");
+
+    const uint entrySize = keyLen + sizeof(TID);
+    for (BlockNo b = metaBlockNo + 1; entryCnt < cnt; b++) {
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+        const char * ptr = bacbStack.top().getDataPtr();
+        uint pageCnt = *(const uint *) ptr;
+        ptr += sizeof(uint);
+        for (uint i = 0; i < pageCnt; ++i) {
+            TID tid;
+            memcpy(&tid, ptr + keyLen, sizeof(TID));
+            insertRec(root, &root, (const unsigned char *) ptr, 0, tid);
+            entryCnt++;
+            ptr += entrySize;
+        }
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+    }
+    LOG4CXX_DEBUG(logger,"Loaded entries: "+TO_STR(entryCnt));
+    replayLog();
+}
+
+uint DBARTIndex::entriesPerPage() const {
+    return (DBFileBlock::getBlockSize() - sizeof(uint)) / (keyLen + sizeof(TID));
+}
+
+uint DBARTIndex::entriesPerLogPage() const {
+    return (DBFileBlock::getBlockSize() - sizeof(uint)) / (keyLen + sizeof(TID) + sizeof(char));
+}
+
+/**
+ * Erste Log-Seite: direkt hinter den Seiten des letzten Snapshots
+ */
+BlockNo DBARTIndex::logStart() {
+    uint snapCnt = ((uint *) bacbStack.top().getDataPtr())[0];
+    return metaBlockNo + 1 + (snapCnt + entriesPerPage() - 1) / entriesPerPage();
+}
+
+/**
+ * Haengt eine Aenderung an das Log an, damit sie ohne Snapshot erhalten bleibt.
+ * Ist das Log laenger als der Snapshot, wird ein neuer Snapshot geschrieben.
+ */
+void DBARTIndex::appendToLog(const unsigned char * key, const TID & tid, bool tombstone) {
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+
+    uint * metaPtr = (uint *) bacbStack.top().getDataPtr();
+    uint logPages = metaPtr[2];
+    if (logPages > 0 && logPages > logStart() - metaBlockNo) {
+        snapshot();
+        return;
+    }
+
+    BlockNo b = logStart() + logPages - 1;
+    if (logPages == 0 || logTailCnt == entriesPerLogPage()) {
+        b++;
+        if (b < bufMgr.getBlockCnt(file))
+            bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+        else
+            bacbStack.push(bufMgr.fixNewBlock(file));
+        *(uint *) bacbStack.top().getDataPtr() = 0;
+        logTailCnt = 0;
+        metaPtr[2] = logPages + 1;
+        LOG4CXX_DEBUG(logger,"New log page "+TO_STR(b));
+    } else {
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    }
+
+    char * ptr = bacbStack.top().getDataPtr();
+    uint * cnt = (uint *) ptr;
+    ptr += sizeof(uint) + (keyLen + sizeof(TID) + sizeof(char)) * (*cnt);
+    memcpy(ptr, key, keyLen);
+    memcpy(ptr + keyLen, &tid, sizeof(TID));
+    ptr[keyLen + sizeof(TID)] = tombstone ? 1 : 0;
+    logTailCnt = ++*cnt;
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    bacbStack.top().setModified();
+}
+
+/**
+ * Spielt die Aenderungen seit dem Snapshot in den Baum nach
+ */
+void DBARTIndex::replayLog() {
+    LOG4CXX_INFO(logger,"replayLog()");
+    const uint entrySize = keyLen + sizeof(TID) + sizeof(char);
+    uint logPages = ((const uint *) bacbStack.top().getDataPtr())[2];
+    BlockNo start = logStart();
+    for (BlockNo b = start; b < start + logPages; b++) {
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+        const char * ptr = bacbStack.top().getDataPtr();
+        logTailCnt = *(const uint *) ptr;
+        ptr += sizeof(uint);
+        for (uint i = 0; i < logTailCnt; ++i, ptr += entrySize) {
+            const unsigned char * key = (const unsigned char *) ptr;
+            if (ptr[keyLen + sizeof(TID)] != 0) {
+                artLeaf * l = removeRec(root, &root, key, 0);
+                if (l != NULL) {
+                    delete[] (char *) l;
+                    entryCnt--;
+                }
+            } else {
+                TID tid;
+                memcpy(&tid, ptr + keyLen, sizeof(TID));
+                if (insertRec(root, &root, key, 0, tid))
+                    entryCnt++;
+            }
+        }
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+    }
+    modified = logPages > 0;
+    LOG4CXX_DEBUG(logger,"Replayed log pages: "+TO_STR(logPages)+", entries: "+TO_STR(entryCnt));
+}
+
+void DBARTIndex::unfixBACBs(bool setDirty) {
+    LOG4CXX_INFO(logger,"unfixBACBs()");
+    LOG4CXX_DEBUG(logger,"setDirty: "+TO_STR(setDirty));
+    LOG4CXX_DEBUG(logger,"bacbStack.size()= "+TO_STR(bacbStack.size()));
+    while (bacbStack.empty() == false) {
+        try {
+            if (bacbStack.top().getModified()) {
+                if (setDirty == true)
+                    bacbStack.top().setDirty();
+            }
+            bufMgr.unfixBlock(bacbStack.top());
+        } catch (DBException & e) {
+        }
+        bacbStack.pop();
+    }
+}
+
+int DBARTIndex::registerClass() {
+    setClassForName("DBARTIndex", createDBARTIndex);
+    return 0;
+}
+
+/**
+ * Gerufen von HubDB::Types::getClassForName von DBTypes, um DBIndex zu erstellen
+ * - DBBufferMgr *: Buffermanager
+ * - DBFile *: Dateiobjekt
+ * - attrType: Attributtp
+ * - ModeType: READ, WRITE
+ * - bool: unique Indexattribut
+ */
+extern "C" void * createDBARTIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBARTIndex(*bufMgr, *file, attrType, m, unique);
+}
@@ -0,0 +1,637 @@
+#include <hubDB/DBHashIndex.h>
+#include <hubDB/DBException.h>
+
+using namespace HubDB::Index;
+using namespace HubDB::Exception;
+
+LoggerPtr DBHashIndex::logger(Logger::getLogger("HubDB.Index.DBHashIndex"));
+
+// registerClass()-Methode am Ende dieser Datei: macht die Klasse der Factory bekannt
+int rHashIdx = DBHashIndex::registerClass();
+const BlockNo DBHashIndex::metaBlockNo(0);
+// Block 0 ist immer der Metablock, kann also nie ein Overflow-Bucket sein
+const BlockNo DBHashIndex::noOverflow(0);
+extern "C" void * createDBHashIndex(int nArgs, va_list ap);
+
+/**
+ * Layout Metablock: | uint globalDepth | BlockNo directory[1 << globalDepth] | ... | BlockNo freeHead |
+ * Layout Bucket:    | uint cnt | uint localDepth | BlockNo overflow | (key, TID) * cnt |
+ * Freie Seiten sind ueber ihr Overflow-Feld verkettet, freeHead == noOverflow: Liste leer
+ */
+#define BUCKET_HEADER_SIZE (2 * sizeof(uint) + sizeof(BlockNo))
+#define BUCKET_CNT(p) ((uint *) (p))
+#define BUCKET_LOCAL_DEPTH(p) ((uint *) (p) + 1)
+#define BUCKET_OVERFLOW(p) ((BlockNo *) ((p) + 2 * sizeof(uint)))
+#define META_FREE_HEAD(p) ((BlockNo *) ((p) + DBFileBlock::getBlockSize() - sizeof(BlockNo)))
+
+DBHashIndex::DBHashIndex(DBBufferMgr &bufferMgr, DBFile &file, enum AttrTypeEnum attrType, ModType mode, bool unique)
+        : DBIndex(bufferMgr, file, attrType, mode, unique) {
+    if (logger != NULL) {
+        LOG4CXX_INFO(logger,"DBHashIndex()");
+    }
+
+    assert(entriesPerBucket()>1);
+    assert(maxGlobalDepth()>0);
+
+    keyBuf = new char[attrTypeSize + sizeof(TID)];
+
+    if (bufMgr.getBlockCnt(file) == 0) {
+        LOG4CXX_DEBUG(logger,"initializeIndex");
+        initializeIndex();
+    }
+
+    //fix meta block, enthaelt das Verzeichnis
+    bacbStack.push(bufMgr.fixBlock(file, metaBlockNo, mode == READ ? LOCK_SHARED : LOCK_INTWRITE));
+
+    if (logger != NULL) {
+        LOG4CXX_DEBUG(logger,"this:\n"+toString("\t"));
+    }
+}
+
+DBHashIndex::~DBHashIndex() {
+    LOG4CXX_INFO(logger,"~DBHashIndex()");
+    unfixBACBs(false);
+    delete[] keyBuf;
+}
+
+string DBHashIndex::toString(string linePrefix) const {
+    return DBIndex::toString(linePrefix);
+}
+
+void DBHashIndex::initializeIndex() {
+    LOG4CXX_INFO(logger,"initializeIndex()");
+    if (bufMgr.getBlockCnt(file) != 0)
+        throw DBIndexException("Can not initialize existing table");
+
+    try {
+        bacbStack.push(bufMgr.fixNewBlock(file));
+        bacbStack.top().setModified();
+        char * metaPtr = bacbStack.top().getDataPtr();
+        uint * globalDepth = (uint *) metaPtr;
+        *globalDepth = 0;
+        BlockNo * directory = (BlockNo *) (metaPtr + sizeof(uint));
+        *META_FREE_HEAD(metaPtr) = noOverflow;
+
+        bacbStack.push(bufMgr.fixNewBlock(file));
+        bacbStack.top().setModified();
+        char * bucketPtr = bacbStack.top().getDataPtr();
+        *BUCKET_CNT(bucketPtr) = 0;
+        *BUCKET_LOCAL_DEPTH(bucketPtr) = 0;
+        *BUCKET_OVERFLOW(bucketPtr) = noOverflow;
+        directory[0] = bacbStack.top().getBlockNo();
+
+        LOG4CXX_DEBUG(logger,"Initial bucket BlockNo: " + TO_STR(directory[0]));
+        LOG4CXX_DEBUG(logger,"Entries per bucket: " + TO_STR(entriesPerBucket()));
+        LOG4CXX_DEBUG(logger,"Max global depth: " + TO_STR(maxGlobalDepth()));
+
+    } catch (DBException & e) {
+        if (bacbStack.empty() == false)
+            bufMgr.unfixBlock(bacbStack.top());
+        if (bacbStack.empty() == false)
+            bufMgr.unfixBlock(bacbStack.top());
+        throw e;
+    }
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+
+    // nun muss die liste der geblockten Seiten wieder leer sein, sonst Abbruch
+    assert(bacbStack.empty()==true);
+}
+
+uint DBHashIndex::entriesPerBucket() const {
+    return (DBFileBlock::getBlockSize() - BUCKET_HEADER_SIZE) /
+           (DBAttrType::getSize4Type(attrType) + sizeof(TID));
+}
+
+uint DBHashIndex::maxGlobalDepth() const {
+    // letzter Slot des Metablocks ist freeHead
+    uint dirSlots = (DBFileBlock::getBlockSize() - sizeof(uint)) / sizeof(BlockNo) - 1;
+    uint depth = 0;
+    while ((2u << depth) <= dirSlots)
+        ++depth;
+    return depth;
+}
+
+/**
+ * Serialisiert den Schluessel in keyBuf. Der Puffer wird vorher genullt, damit
+ * Fuellbytes (z.B. bei VCHAR) weder Hashwert noch Vergleich beeinflussen.
+ * Gueltig bis zum naechsten Aufruf
+ */
+const char * DBHashIndex::keyBytes(const DBAttrType & val) const {
+    memset(keyBuf, 0, attrTypeSize);
+    val.write(keyBuf);
+    return keyBuf;
+}
+
+/**
+ * FNV-1a ueber die serialisierte Darstellung des Schluessels
+ */
+uint DBHashIndex::hashBytes(const char * key) const {
+    uint h = 2166136261u;
+    for (uint i = 0; i < attrTypeSize; ++i) {
+        h ^= (unsigned char) key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+uint * DBHashIndex::globalDepthPtr() {
+    // Metablock liegt immer ganz unten auf dem Stack
+    return (uint *) bacbStack.top().getDataPtr();
+}
+
+BlockNo * DBHashIndex::directoryPtr() {
+    return (BlockNo *) (bacbStack.top().getDataPtr() + sizeof(uint));
+}
+
+BlockNo * DBHashIndex::freeHeadPtr() {
+    return META_FREE_HEAD(bacbStack.top().getDataPtr());
+}
+
+/**
+ * Liefert eine exklusiv gefixte Seite, bevorzugt aus der Freiliste.
+ * Der Metablock muss oben auf dem Stack liegen, die Seite wird nicht auf den Stack gelegt
+ */
+DBBACB DBHashIndex::fixFreeBlock() {
+    BlockNo * freeHead = freeHeadPtr();
+    if (*freeHead == noOverflow)
+        return bufMgr.fixNewBlock(file);
+    LOG4CXX_DEBUG(logger,"Reusing free BlockNo "+TO_STR(*freeHead));
+    DBBACB bacb = bufMgr.fixBlock(file, *freeHead, LOCK_EXCLUSIVE);
+    *freeHead = *BUCKET_OVERFLOW(bacb.getDataPtr());
+    bacbStack.top().setModified();
+    return bacb;
+}
+
+/**
+ * Haengt Seite b vorne in die Freiliste. Der Metablock muss oben auf dem Stack liegen
+ */
+void DBHashIndex::releaseBlock(BlockNo b) {
+    LOG4CXX_DEBUG(logger,"Releasing BlockNo "+TO_STR(b));
+    BlockNo * freeHead = freeHeadPtr();
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    char * ptr = bacbStack.top().getDataPtr();
+    *BUCKET_CNT(ptr) = 0;
+    *BUCKET_OVERFLOW(ptr) = *freeHead;
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    *freeHead = b;
+    bacbStack.top().setModified();
+}
+
+void DBHashIndex::find(const DBAttrType &val, DBListTID &tids) {
+    LOG4CXX_INFO(logger,"find()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+
+    tids.clear();
+
+    const char * key = keyBytes(val);
+    uint dirIdx = hashBytes(key) & ((1u << *globalDepthPtr()) - 1);
+    BlockNo b = directoryPtr()[dirIdx];
+    LOG4CXX_DEBUG(logger,"Directory slot "+TO_STR(dirIdx)+" -> BlockNo "+TO_STR(b));
+
+    findInBucket(key, b, tids);
+
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+}
+
+void DBHashIndex::findInBucket(const char * key, BlockNo b, DBListTID & tids) {
+    LOG4CXX_INFO(logger,"findInBucket()");
+
+    //Bucket und alle Overflow-Seiten durchsuchen
+    while (b != noOverflow) {
+        LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b));
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+        const char * ptr = bacbStack.top().getDataPtr();
+        uint cnt = *BUCKET_CNT(ptr);
+        b = *BUCKET_OVERFLOW(ptr);
+        ptr += BUCKET_HEADER_SIZE;
+        for (uint i = 0; i < cnt; ++i) {
+            if (memcmp(ptr, key, attrTypeSize) == 0) {
+                TID result = *(TID *) (ptr + attrTypeSize);
+                LOG4CXX_DEBUG(logger,"Found TID: "+result.toString());
+                tids.push_back(result);
+            }
+            ptr += attrTypeSize + sizeof(TID);
+        }
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+
+        if (unique == true && tids.empty() == false)
+            break;
+    }
+}
+
+void DBHashIndex::insert(const DBAttrType &val, const TID &tid) {
+    LOG4CXX_INFO(logger,"insert()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+    LOG4CXX_DEBUG(logger,"tid: "+tid.toString());
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+
+    // keyBuf haelt danach den vollstaendigen Eintrag (key, TID)
+    const char * entry = keyBytes(val);
+    uint h = hashBytes(entry);
+
+    if (unique == true) {
+        DBListTID existing;
+        findInBucket(entry, directoryPtr()[h & ((1u << *globalDepthPtr()) - 1)], existing);
+        if (existing.empty() == false)
+            throw DBIndexException("Insert failed, entry already exists with TID "+existing.front().toString());
+    }
+
+    memcpy(keyBuf + attrTypeSize, &tid, sizeof(TID));
+
+    while (true) {
+        uint globalDepth = *globalDepthPtr();
+        uint dirIdx = h & ((1u << globalDepth) - 1);
+        BlockNo b = directoryPtr()[dirIdx];
+        if (appendToBucket(b, entry, false))
+            break;
+
+        //Bucket ist voll: splitten, Verzeichnis ggf. verdoppeln
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+        uint localDepth = *BUCKET_LOCAL_DEPTH(bacbStack.top().getDataPtr());
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+
+        if (bucketHoldsOnlyHash(b, h)) {
+            //Splitten trennt nur verschiedene Hashwerte (z.B. Duplikate bei non-unique) -> Overflow
+            LOG4CXX_DEBUG(logger,"Bucket holds a single hash value, using overflow page");
+            appendToBucket(b, entry, true);
+            break;
+        }
+        if (localDepth == globalDepth) {
+            if (globalDepth == maxGlobalDepth()) {
+                //Verzeichnis passt nicht mehr in den Metablock -> Overflow
+                LOG4CXX_DEBUG(logger,"Directory at max depth, using overflow page");
+                appendToBucket(b, entry, true);
+                break;
+            }
+            doubleDirectory();
+        }
+        splitBucket(dirIdx);
+    }
+
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+}
+
+/**
+ * Haengt einen Eintrag an die Bucket-Kette an.
+ * allowOverflow == false: nur freier Platz in vorhandenen Seiten wird genutzt
+ */
+bool DBHashIndex::appendToBucket(BlockNo b, const char * entry, bool allowOverflow) {
+    LOG4CXX_INFO(logger,"appendToBucket()");
+    const uint entrySize = attrTypeSize + sizeof(TID);
+
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    while (*BUCKET_CNT(bacbStack.top().getDataPtr()) == entriesPerBucket()) {
+        char * ptr = bacbStack.top().getDataPtr();
+        BlockNo next = *BUCKET_OVERFLOW(ptr);
+        if (next == noOverflow) {
+            if (allowOverflow == false) {
+                bufMgr.unfixBlock(bacbStack.top());
+                bacbStack.pop();
+                return false;
+            }
+            //Seite freigeben, damit der Metablock fuer fixFreeBlock() oben liegt
+            BlockNo last = bacbStack.top().getBlockNo();
+            uint localDepth = *BUCKET_LOCAL_DEPTH(ptr);
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+
+            bacbStack.push(fixFreeBlock());
+            char * newPtr = bacbStack.top().getDataPtr();
+            *BUCKET_CNT(newPtr) = 0;
+            *BUCKET_LOCAL_DEPTH(newPtr) = localDepth;
+            *BUCKET_OVERFLOW(newPtr) = noOverflow;
+            bacbStack.top().setModified();
+            BlockNo overflow = bacbStack.top().getBlockNo();
+
+            bacbStack.push(bufMgr.fixBlock(file, last, LOCK_EXCLUSIVE));
+            *BUCKET_OVERFLOW(bacbStack.top().getDataPtr()) = overflow;
+            LOG4CXX_DEBUG(logger,"New overflow page "+TO_STR(overflow)+" for BlockNo "+TO_STR(last));
+            bacbStack.top().setModified();
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+        } else {
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+            bacbStack.push(bufMgr.fixBlock(file, next, LOCK_EXCLUSIVE));
+        }
+    }
+
+    char * ptr = bacbStack.top().getDataPtr();
+    uint * cnt = BUCKET_CNT(ptr);
+    memcpy(ptr + BUCKET_HEADER_SIZE + entrySize * (*cnt), entry, entrySize);
+    ++*cnt;
+    LOG4CXX_DEBUG(logger,"Appended to BlockNo "+TO_STR(bacbStack.top().getBlockNo())+", cnt "+TO_STR(*cnt));
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    return true;
+}
+
+void DBHashIndex::doubleDirectory() {
+    LOG4CXX_INFO(logger,"doubleDirectory()");
+    uint * globalDepth = globalDepthPtr();
+    BlockNo * directory = directoryPtr();
+    uint size = 1u << *globalDepth;
+    memcpy(directory + size, directory, size * sizeof(BlockNo));
+    ++*globalDepth;
+    bacbStack.top().setModified();
+    LOG4CXX_DEBUG(logger,"New global depth: "+TO_STR(*globalDepth));
+}
+
+/**
+ * true, wenn alle Eintraege der ersten Seite von Bucket b den Hashwert h haben.
+ * Dann kann kein Split den Bucket entlasten
+ */
+bool DBHashIndex::bucketHoldsOnlyHash(BlockNo b, uint h) {
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+    const char * ptr = bacbStack.top().getDataPtr();
+    uint cnt = *BUCKET_CNT(ptr);
+    ptr += BUCKET_HEADER_SIZE;
+    bool same = true;
+    for (uint i = 0; i < cnt && same == true; ++i, ptr += entrySize)
+        same = hashBytes(ptr) == h;
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    return same;
+}
+
+/**
+ * Teilt den Bucket (samt Overflow-Kette) von Verzeichnisslot dirIdx anhand
+ * des naechsten Hashbits auf. Overflow-Seiten kommen in die Freiliste
+ * und werden beim Neuverteilen bei Bedarf wiederverwendet.
+ */
+void DBHashIndex::splitBucket(uint dirIdx) {
+    LOG4CXX_INFO(logger,"splitBucket()");
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    BlockNo * directory = directoryPtr();
+    BlockNo oldBlockNo = directory[dirIdx];
+
+    //alle Eintraege der Kette einsammeln und die Kette leeren
+    vector<char> entries;
+    vector<BlockNo> overflowPages;
+    uint localDepth = 0;
+    BlockNo b = oldBlockNo;
+    while (b != noOverflow) {
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+        char * ptr = bacbStack.top().getDataPtr();
+        uint * cnt = BUCKET_CNT(ptr);
+        entries.insert(entries.end(), ptr + BUCKET_HEADER_SIZE, ptr + BUCKET_HEADER_SIZE + entrySize * (*cnt));
+        *cnt = 0;
+        b = *BUCKET_OVERFLOW(ptr);
+        if (bacbStack.top().getBlockNo() == oldBlockNo) {
+            localDepth = *BUCKET_LOCAL_DEPTH(ptr);
+            ++*BUCKET_LOCAL_DEPTH(ptr);
+            *BUCKET_OVERFLOW(ptr) = noOverflow;
+        } else {
+            overflowPages.push_back(bacbStack.top().getBlockNo());
+        }
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+    }
+    for (uint i = 0; i < overflowPages.size(); ++i)
+        releaseBlock(overflowPages[i]);
+
+    bacbStack.push(fixFreeBlock());
+    char * newPtr = bacbStack.top().getDataPtr();
+    *BUCKET_CNT(newPtr) = 0;
+    *BUCKET_LOCAL_DEPTH(newPtr) = localDepth + 1;
+    *BUCKET_OVERFLOW(newPtr) = noOverflow;
+    BlockNo newBlockNo = bacbStack.top().getBlockNo();
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    LOG4CXX_DEBUG(logger,"Split BlockNo "+TO_STR(oldBlockNo)+" (local depth "+TO_STR(localDepth)+"), new BlockNo "+TO_STR(newBlockNo));
+
+    //Verzeichnis: alle Slots des alten Buckets mit gesetztem Bit localDepth zeigen auf den neuen
+    uint dirSize = 1u << *globalDepthPtr();
+    uint lowMask = (1u << localDepth) - 1;
+    for (uint i = 0; i < dirSize; ++i) {
+        if ((i & lowMask) == (dirIdx & lowMask) && ((i >> localDepth) & 1) == 1)
+            directory[i] = newBlockNo;
+    }
+    bacbStack.top().setModified();
+
+    //Eintraege neu verteilen
+    uint entryCnt = entries.size() / entrySize;
+    for (uint i = 0; i < entryCnt; ++i) {
+        const char * entry = &entries[i * entrySize];
+        BlockNo target = ((hashBytes(entry) >> localDepth) & 1) == 1 ? newBlockNo : oldBlockNo;
+        appendToBucket(target, entry, true);
+    }
+}
+
+void DBHashIndex::remove(const DBAttrType &val, const DBListTID &tid) {
+    LOG4CXX_INFO(logger,"remove()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const char * key = keyBytes(val);
+    uint dirIdx = hashBytes(key) & ((1u << *globalDepthPtr()) - 1);
+    BlockNo primary = directoryPtr()[dirIdx];
+
+    //leer gewordene Overflow-Seiten werden ausgehaengt und kommen in die Freiliste
+    BlockNo prev = noOverflow;
+    BlockNo b = primary;
+    while (b != noOverflow) {
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+        char * ptr = bacbStack.top().getDataPtr();
+        uint * cnt = BUCKET_CNT(ptr);
+        BlockNo next = *BUCKET_OVERFLOW(ptr);
+        char * entry = ptr + BUCKET_HEADER_SIZE;
+        for (uint i = 0; i < *cnt;) {
+            bool match = false;
+            if (memcmp(entry, key, attrTypeSize) == 0) {
+                TID * entryTid = (TID *) (entry + attrTypeSize);
+                for (DBListTID::const_iterator it = tid.begin(); it != tid.end() && match == false; ++it)
+                    match = *it == *entryTid;
+            }
+            if (match) {
+                LOG4CXX_DEBUG(logger,"Removing TID "+((TID *) (entry + attrTypeSize))->toString()+" from BlockNo "+TO_STR(bacbStack.top().getBlockNo()));
+                memmove(entry, entry + entrySize, entrySize * (*cnt - i - 1));
+                --*cnt;
+                bacbStack.top().setModified();
+            } else {
+                entry += entrySize;
+                ++i;
+            }
+        }
+        bool unlink = *cnt == 0 && b != primary;
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+
+        if (unlink) {
+            bacbStack.push(bufMgr.fixBlock(file, prev, LOCK_EXCLUSIVE));
+            *BUCKET_OVERFLOW(bacbStack.top().getDataPtr()) = next;
+            bacbStack.top().setModified();
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+            releaseBlock(b);
+        } else {
+            prev = b;
+        }
+        b = next;
+    }
+
+    //leere erste Seite: Inhalt der ersten Overflow-Seite nachziehen
+    bacbStack.push(bufMgr.fixBlock(file, primary, LOCK_EXCLUSIVE));
+    char * ptr = bacbStack.top().getDataPtr();
+    BlockNo next = *BUCKET_OVERFLOW(ptr);
+    if (*BUCKET_CNT(ptr) == 0 && next != noOverflow) {
+        bacbStack.push(bufMgr.fixBlock(file, next, LOCK_SHARED));
+        const char * nextPtr = bacbStack.top().getDataPtr();
+        uint cnt = *BUCKET_CNT(nextPtr);
+        memcpy(ptr + BUCKET_HEADER_SIZE, nextPtr + BUCKET_HEADER_SIZE, entrySize * cnt);
+        *BUCKET_CNT(ptr) = cnt;
+        *BUCKET_OVERFLOW(ptr) = *BUCKET_OVERFLOW(nextPtr);
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        bacbStack.top().setModified();
+        LOG4CXX_DEBUG(logger,"Pulled overflow page "+TO_STR(next)+" into BlockNo "+TO_STR(primary));
+    } else {
+        next = noOverflow;
+    }
+    bool empty = *BUCKET_CNT(ptr) == 0;
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    if (next != noOverflow)
+        releaseBlock(next);
+
+    if (empty)
+        mergeEmptyBucket(dirIdx);
+
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+}
+
+/**
+ * Verschmilzt den leeren Bucket von Verzeichnisslot dirIdx mit seinem Buddy
+ * (gleiche lokale Tiefe, unterscheidet sich nur im Bit localDepth-1), solange
+ * das Ergebnis wieder leer ist. Danach schrumpft ggf. das Verzeichnis
+ */
+void DBHashIndex::mergeEmptyBucket(uint dirIdx) {
+    LOG4CXX_INFO(logger,"mergeEmptyBucket()");
+    while (true) {
+        BlockNo * directory = directoryPtr();
+        uint dirSize = 1u << *globalDepthPtr();
+        dirIdx &= dirSize - 1;
+        BlockNo b = directory[dirIdx];
+
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+        const char * ptr = bacbStack.top().getDataPtr();
+        uint localDepth = *BUCKET_LOCAL_DEPTH(ptr);
+        bool empty = *BUCKET_CNT(ptr) == 0 && *BUCKET_OVERFLOW(ptr) == noOverflow;
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        if (empty == false || localDepth == 0)
+            break;
+
+        BlockNo buddy = directory[dirIdx ^ (1u << (localDepth - 1))];
+        bacbStack.push(bufMgr.fixBlock(file, buddy, LOCK_EXCLUSIVE));
+        char * buddyPtr = bacbStack.top().getDataPtr();
+        if (*BUCKET_LOCAL_DEPTH(buddyPtr) != localDepth) {
+            //Buddy ist tiefer gesplittet, kein Verschmelzen moeglich
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+            break;
+        }
+        --*BUCKET_LOCAL_DEPTH(buddyPtr);
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        LOG4CXX_DEBUG(logger,"Merging empty BlockNo "+TO_STR(b)+" into buddy "+TO_STR(buddy));
+
+        for (uint i = 0; i < dirSize; ++i) {
+            if (directory[i] == b)
+                directory[i] = buddy;
+        }
+        bacbStack.top().setModified();
+        releaseBlock(b);
+        shrinkDirectory();
+    }
+}
+
+/**
+ * Halbiert das Verzeichnis, solange beide Haelften identisch sind
+ * (d.h. kein Bucket hat lokale Tiefe == globale Tiefe)
+ */
+void DBHashIndex::shrinkDirectory() {
+    uint * globalDepth = globalDepthPtr();
+    BlockNo * directory = directoryPtr();
+    while (*globalDepth > 0) {
+        uint half = 1u << (*globalDepth - 1);
+        if (memcmp(directory, directory + half, half * sizeof(BlockNo)) != 0)
+            break;
+        --*globalDepth;
+        bacbStack.top().setModified();
+        LOG4CXX_DEBUG(logger,"New global depth: "+TO_STR(*globalDepth));
+    }
+}
+
+void DBHashIndex::unfixBACBs(bool setDirty) {
+    LOG4CXX_INFO(logger,"unfixBACBs()");
+    LOG4CXX_DEBUG(logger,"setDirty: "+TO_STR(setDirty));
+    LOG4CXX_DEBUG(logger,"bacbStack.size()= "+TO_STR(bacbStack.size()));
+    while (bacbStack.empty() == false) {
+        try {
+            if (bacbStack.top().getModified()) {
+                if (setDirty == true)
+                    bacbStack.top().setDirty();
+            }
+            bufMgr.unfixBlock(bacbStack.top());
+        } catch (DBException & e) {
+        }
+        bacbStack.pop();
+    }
+}
+
+int DBHashIndex::registerClass() {
+    setClassForName("DBHashIndex", createDBHashIndex);
+    return 0;
+}
+
+/**
+ * Gerufen von HubDB::Types::getClassForName von DBTypes, um DBIndex zu erstellen
+ * - DBBufferMgr *: Buffermanager
+ * - DBFile *: Dateiobjekt
+ * - attrType: Attributtp
+ * - ModeType: READ, WRITE
+ * - bool: unique Indexattribut
+ */
+extern "C" void * createDBHashIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBHashIndex(*bufMgr, *file, attrType, m, unique);
+}
@@ -0,0 +1,872 @@
+#include <hubDB/DBLSMIndex.h>
+#include <hubDB/DBException.h>
+
+using namespace HubDB::Index;
+using namespace HubDB::Exception;
+
+LoggerPtr DBLSMIndex::logger(Logger::getLogger("HubDB.Index.DBLSMIndex"));
+
+// registerClass()-Methode am Ende dieser Datei: macht die Klasse der Factory bekannt
+int rLSMIdx = DBLSMIndex::registerClass();
+const BlockNo DBLSMIndex::metaBlockNo(0);
+// Block 0 ist immer der Metablock und markiert daher das Ende einer Seitenkette
+const BlockNo DBLSMIndex::noBlock(0);
+const uint DBLSMIndex::maxLevel0Runs(4);
+const uint DBLSMIndex::memTablePages(16);
+const uint DBLSMIndex::levelSizeRatio(10);
+const uint DBLSMIndex::bloomBitsPerKey(10);
+const uint DBLSMIndex::bloomHashCnt(7);
+extern "C" void * createDBLSMIndex(int nArgs, va_list ap);
+
+/**
+ * Layout Metablock:   | uint runCnt | BlockNo freeHead | BlockNo logHead | runDesc * runCnt |
+ *   runDesc:          | uint level | uint entryCnt | BlockNo fenceBlock | BlockNo bloomBlock | uint bloomBits |
+ * Layout Datenseite:  | uint cnt | (key, TID, char tombstone) * cnt |
+ * Layout Fence-Seite: | BlockNo next | uint cnt | (key, BlockNo) * cnt |
+ * Layout Bloom-Seite: | BlockNo next | bits |
+ * Layout Log-Seite:   | BlockNo next | uint cnt | (key, TID, char tombstone) * cnt |
+ * Layout freie Seite: | BlockNo next |
+ * Runs liegen im Metablock (und in runs) nach Level aufsteigend, in Level 0
+ * der neueste zuerst: die Reihenfolge ist damit auch die Suchreihenfolge.
+ * Das Log enthaelt alle Aenderungen seit dem letzten Flush der Memtable in
+ * Reihenfolge; ein Flush traegt den neuen Run ein und leert das Log mit
+ * demselben Schreiben des Metablocks.
+ */
+#define META_RUN_CNT(p) ((uint *) (p))
+#define META_FREE_HEAD(p) ((BlockNo *) ((p) + sizeof(uint)))
+#define META_LOG_HEAD(p) ((BlockNo *) ((p) + sizeof(uint) + sizeof(BlockNo)))
+#define META_HEADER_SIZE (sizeof(uint) + 2 * sizeof(BlockNo))
+#define RUN_DESC_SIZE (3 * sizeof(uint) + 2 * sizeof(BlockNo))
+#define DATA_ENTRY_SIZE (attrTypeSize + sizeof(TID) + sizeof(char))
+#define FENCE_HEADER_SIZE (sizeof(BlockNo) + sizeof(uint))
+#define LOG_HEADER_SIZE (sizeof(BlockNo) + sizeof(uint))
+#define LOG_CNT(p) ((uint *) ((p) + sizeof(BlockNo)))
+
+DBLSMIndex::DBLSMIndex(DBBufferMgr &bufferMgr, DBFile &file, enum AttrTypeEnum attrType, ModType mode, bool unique)
+        : DBIndex(bufferMgr, file, attrType, mode, unique) {
+    if (logger != NULL) {
+        LOG4CXX_INFO(logger,"DBLSMIndex()");
+    }
+
+    assert(entriesPerDataPage()>1);
+    assert(fencesPerPage()>1);
+    assert(maxRuns()>maxLevel0Runs+1);
+
+    logTail = noBlock;
+    logEntries = 0;
+    keyBuf = new char[attrTypeSize];
+
+    if (bufMgr.getBlockCnt(file) == 0) {
+        LOG4CXX_DEBUG(logger,"initializeIndex");
+        initializeIndex();
+    }
+
+    //fix meta block
+    bacbStack.push(bufMgr.fixBlock(file, metaBlockNo, mode == READ ? LOCK_SHARED : LOCK_INTWRITE));
+    readMeta();
+
+    if (logger != NULL) {
+        LOG4CXX_DEBUG(logger,"this:\n"+toString("\t"));
+    }
+}
+
+DBLSMIndex::~DBLSMIndex() {
+    LOG4CXX_INFO(logger,"~DBLSMIndex()");
+    //Memtable beim Schliessen als Run sichern, spart das Nachspielen des Logs
+    if (mem.empty() == false && bacbStack.size() == 1 && bacbStack.top().getLockMode() != LOCK_SHARED) {
+        try {
+            if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+                bufMgr.upgradeToExclusive(bacbStack.top());
+            flushMemTable();
+        } catch (DBException & e) {
+            LOG4CXX_ERROR(logger,"could not flush memtable on close");
+        }
+    }
+    clearMemTable();
+    unfixBACBs(false);
+    delete[] keyBuf;
+}
+
+string DBLSMIndex::toString(string linePrefix) const {
+    stringstream ss;
+    ss << DBIndex::toString(linePrefix);
+    ss << linePrefix << "memtable entries: " << mem.size() << "\n";
+    for (uint i = 0; i < runs.size(); ++i) {
+        ss << linePrefix << "run " << i << ": level " << runs[i].level
+           << ", entries " << runs[i].entryCnt << ", pages " << runs[i].fencePages.size() << "\n";
+    }
+    return ss.str();
+}
+
+void DBLSMIndex::initializeIndex() {
+    LOG4CXX_INFO(logger,"initializeIndex()");
+    if (bufMgr.getBlockCnt(file) != 0)
+        throw DBIndexException("Can not initialize existing table");
+
+    try {
+        bacbStack.push(bufMgr.fixNewBlock(file));
+        bacbStack.top().setModified();
+        char * metaPtr = bacbStack.top().getDataPtr();
+        *META_RUN_CNT(metaPtr) = 0;
+        *META_FREE_HEAD(metaPtr) = noBlock;
+        *META_LOG_HEAD(metaPtr) = noBlock;
+    } catch (DBException & e) {
+        if (bacbStack.empty() == false)
+            bufMgr.unfixBlock(bacbStack.top());
+        throw e;
+    }
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+
+    // nun muss die liste der geblockten Seiten wieder leer sein, sonst Abbruch
+    assert(bacbStack.empty()==true);
+}
+
+uint DBLSMIndex::entriesPerDataPage() const {
+    return (DBFileBlock::getBlockSize() - sizeof(uint)) /
+           (DBAttrType::getSize4Type(attrType) + sizeof(TID) + sizeof(char));
+}
+
+uint DBLSMIndex::fencesPerPage() const {
+    return (DBFileBlock::getBlockSize() - FENCE_HEADER_SIZE) /
+           (DBAttrType::getSize4Type(attrType) + sizeof(BlockNo));
+}
+
+uint DBLSMIndex::entriesPerLogPage() const {
+    return (DBFileBlock::getBlockSize() - LOG_HEADER_SIZE) /
+           (DBAttrType::getSize4Type(attrType) + sizeof(TID) + sizeof(char));
+}
+
+uint DBLSMIndex::maxRuns() const {
+    return (DBFileBlock::getBlockSize() - META_HEADER_SIZE) / RUN_DESC_SIZE;
+}
+
+uint DBLSMIndex::memTableLimit() const {
+    return entriesPerDataPage() * memTablePages;
+}
+
+uint DBLSMIndex::levelCapacity(uint level) const {
+    uint capacity = memTableLimit() * maxLevel0Runs;
+    for (uint i = 1; i < level; ++i)
+        capacity *= levelSizeRatio;
+    return capacity;
+}
+
+void DBLSMIndex::readMeta() {
+    LOG4CXX_INFO(logger,"readMeta()");
+    const char * ptr = bacbStack.top().getDataPtr();
+    uint runCnt = *META_RUN_CNT(ptr);
+    ptr += META_HEADER_SIZE;
+    runs.resize(runCnt);
+    for (uint i = 0; i < runCnt; ++i) {
+        const uint * desc = (const uint *) ptr;
+        runs[i].level = desc[0];
+        runs[i].entryCnt = desc[1];
+        runs[i].fenceBlock = desc[2];
+        runs[i].bloomBlock = desc[3];
+        runs[i].bloomBits = desc[4];
+        ptr += RUN_DESC_SIZE;
+    }
+    for (uint i = 0; i < runCnt; ++i)
+        loadRun(runs[i]);
+    LOG4CXX_DEBUG(logger,"Runs: "+TO_STR(runCnt));
+    replayLog();
+}
+
+void DBLSMIndex::writeMeta() {
+    LOG4CXX_INFO(logger,"writeMeta()");
+    if (runs.size() > maxRuns())
+        throw DBIndexException("Too many runs for meta block");
+    char * ptr = bacbStack.top().getDataPtr();
+    *META_RUN_CNT(ptr) = runs.size();
+    ptr += META_HEADER_SIZE;
+    for (uint i = 0; i < runs.size(); ++i) {
+        uint * desc = (uint *) ptr;
+        desc[0] = runs[i].level;
+        desc[1] = runs[i].entryCnt;
+        desc[2] = runs[i].fenceBlock;
+        desc[3] = runs[i].bloomBlock;
+        desc[4] = runs[i].bloomBits;
+        ptr += RUN_DESC_SIZE;
+    }
+    bacbStack.top().setModified();
+}
+
+/**
+ * Laedt Fence-Index und Bloom-Filter eines Runs in den Hauptspeicher
+ */
+void DBLSMIndex::loadRun(runInfo & run) {
+    LOG4CXX_INFO(logger,"loadRun()");
+    vector<char> page;
+    BlockNo b = run.fenceBlock;
+    while (b != noBlock) {
+        loadPage(b, page);
+        const char * ptr = &page[0];
+        b = *(BlockNo *) ptr;
+        uint cnt = *(uint *) (ptr + sizeof(BlockNo));
+        ptr += FENCE_HEADER_SIZE;
+        for (uint i = 0; i < cnt; ++i) {
+            run.fenceKeys.insert(run.fenceKeys.end(), ptr, ptr + attrTypeSize);
+            ptr += attrTypeSize;
+            run.fencePages.push_back(*(BlockNo *) ptr);
+            ptr += sizeof(BlockNo);
+        }
+    }
+
+    run.bloom.assign((run.bloomBits + 7) / 8, 0);
+    const uint bytesPerPage = DBFileBlock::getBlockSize() - sizeof(BlockNo);
+    uint offset = 0;
+    b = run.bloomBlock;
+    while (b != noBlock) {
+        loadPage(b, page);
+        b = *(BlockNo *) &page[0];
+        uint len = min(bytesPerPage, (uint) run.bloom.size() - offset);
+        memcpy(&run.bloom[offset], &page[sizeof(BlockNo)], len);
+        offset += len;
+    }
+}
+
+/**
+ * Gibt alle Seiten eines Runs frei
+ */
+void DBLSMIndex::dropRun(runInfo & run) {
+    LOG4CXX_INFO(logger,"dropRun()");
+    vector<char> page;
+    for (uint i = 0; i < run.fencePages.size(); ++i)
+        freePage(run.fencePages[i]);
+    run.fenceKeys.clear();
+    run.fencePages.clear();
+
+    BlockNo chains[2] = { run.fenceBlock, run.bloomBlock };
+    for (uint i = 0; i < 2; ++i) {
+        BlockNo b = chains[i];
+        while (b != noBlock) {
+            loadPage(b, page);
+            BlockNo next = *(BlockNo *) &page[0];
+            freePage(b);
+            b = next;
+        }
+    }
+}
+
+BlockNo DBLSMIndex::allocPage() {
+    BlockNo * freeHead = META_FREE_HEAD(bacbStack.top().getDataPtr());
+    if (*freeHead == noBlock) {
+        bacbStack.push(bufMgr.fixNewBlock(file));
+    } else {
+        bacbStack.push(bufMgr.fixBlock(file, *freeHead, LOCK_EXCLUSIVE));
+        BlockNo * next = (BlockNo *) bacbStack.top().getDataPtr();
+        BlockNo * metaFreeHead = freeHead;
+        *metaFreeHead = *next;
+    }
+    BlockNo b = bacbStack.top().getBlockNo();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    bacbStack.top().setModified();
+    return b;
+}
+
+void DBLSMIndex::freePage(BlockNo b) {
+    BlockNo * freeHead = META_FREE_HEAD(bacbStack.top().getDataPtr());
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    *(BlockNo *) bacbStack.top().getDataPtr() = *freeHead;
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    *freeHead = b;
+    bacbStack.top().setModified();
+}
+
+void DBLSMIndex::loadPage(BlockNo b, vector<char> & page) {
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+    const char * ptr = bacbStack.top().getDataPtr();
+    page.assign(ptr, ptr + DBFileBlock::getBlockSize());
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+}
+
+BlockNo DBLSMIndex::writePage(const vector<char> & page) {
+    BlockNo b = allocPage();
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    memcpy(bacbStack.top().getDataPtr(), &page[0], DBFileBlock::getBlockSize());
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    return b;
+}
+
+void DBLSMIndex::normalizeKey(const DBAttrType & val, char * buf) const {
+    memset(buf, 0, attrTypeSize);
+    val.write(buf);
+}
+
+/**
+ * Vergleich serialisierter Schluessel ohne DBAttrType-Objekte,
+ * VCHAR ist mit Nullen aufgefuellt und kann bytweise verglichen werden
+ */
+int DBLSMIndex::compareKeys(const char * a, const char * b) const {
+    if (attrType == INT) {
+        int x, y;
+        memcpy(&x, a, sizeof(int));
+        memcpy(&y, b, sizeof(int));
+        return (y < x) - (x < y);
+    } else if (attrType == DOUBLE) {
+        double x, y;
+        memcpy(&x, a, sizeof(double));
+        memcpy(&y, b, sizeof(double));
+        return (y < x) - (x < y);
+    }
+    return memcmp(a, b, attrTypeSize);
+}
+
+/**
+ * Zwei FNV-1a Hashes mit unterschiedlichem Startwert, daraus werden per
+ * double hashing bloomHashCnt Bitpositionen abgeleitet
+ */
+void DBLSMIndex::bloomHashes(const char * key, uint & h1, uint & h2) const {
+    h1 = 2166136261u;
+    h2 = 0x9747b28cu;
+    for (uint i = 0; i < attrTypeSize; ++i) {
+        h1 = (h1 ^ (unsigned char) key[i]) * 16777619u;
+        h2 = (h2 ^ (unsigned char) key[i]) * 16777619u;
+    }
+    h2 |= 1;
+}
+
+bool DBLSMIndex::bloomMayContain(const runInfo & run, const char * key) const {
+    if (run.bloomBits == 0)
+        return true;
+    uint h1, h2;
+    bloomHashes(key, h1, h2);
+    for (uint i = 0; i < bloomHashCnt; ++i) {
+        uint bit = (h1 + i * h2) % run.bloomBits;
+        if ((run.bloom[bit / 8] & (1 << (bit % 8))) == 0)
+            return false;
+    }
+    return true;
+}
+
+void DBLSMIndex::putMemTable(const char * key, const TID & tid, bool tombstone) {
+    memEntry entry;
+    entry.tid = tid;
+    entry.tombstone = tombstone;
+    DBAttrType * attr = DBAttrType::read(key, attrType);
+    memTable::iterator it = mem.find(attr);
+    if (it != mem.end()) {
+        it->second = entry;
+        delete attr;
+    } else {
+        mem.insert(make_pair(attr, entry));
+    }
+}
+
+void DBLSMIndex::clearMemTable() {
+    for (memTable::iterator it = mem.begin(); it != mem.end(); ++it)
+        delete it->first;
+    mem.clear();
+}
+
+bool DBLSMIndex::findInMemTable(const DBAttrType & val, memEntry & result) {
+    memTable::iterator it = mem.find(const_cast<DBAttrType *>(&val));
+    if (it == mem.end())
+        return false;
+    result = it->second;
+    return true;
+}
+
+/**
+ * Fence-Index (im Hauptspeicher) binaer durchsuchen, dann genau eine Datenseite fixen
+ */
+bool DBLSMIndex::findInRun(const runInfo & run, const char * key, memEntry & result) {
+    if (bloomMayContain(run, key) == false)
+        return false;
+    if (run.fencePages.empty() || compareKeys(key, &run.fenceKeys[0]) < 0)
+        return false;
+
+    uint lo = 0, hi = run.fencePages.size();
+    while (hi - lo > 1) {
+        uint mid = (lo + hi) / 2;
+        if (compareKeys(key, &run.fenceKeys[attrTypeSize * mid]) < 0)
+            hi = mid;
+        else
+            lo = mid;
+    }
+
+    bool found = false;
+    bacbStack.push(bufMgr.fixBlock(file, run.fencePages[lo], LOCK_SHARED));
+    const char * ptr = bacbStack.top().getDataPtr();
+    uint cnt = *(uint *) ptr;
+    ptr += sizeof(uint);
+    lo = 0;
+    hi = cnt;
+    while (lo < hi && found == false) {
+        uint mid = (lo + hi) / 2;
+        const char * entry = ptr + DATA_ENTRY_SIZE * mid;
+        int cmp = compareKeys(entry, key);
+        if (cmp == 0) {
+            memcpy(&result.tid, entry + attrTypeSize, sizeof(TID));
+            result.tombstone = entry[attrTypeSize + sizeof(TID)] != 0;
+            found = true;
+        } else if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    return found;
+}
+
+/**
+ * Neuester Stand eines Schluessels: erst Memtable, dann Runs vom neuesten zum aeltesten
+ */
+bool DBLSMIndex::lookup(const DBAttrType & val, memEntry & result) {
+    if (findInMemTable(val, result))
+        return result.tombstone == false;
+
+    normalizeKey(val, keyBuf);
+    bool found = false;
+    for (uint i = 0; i < runs.size(); ++i) {
+        if (findInRun(runs[i], keyBuf, result)) {
+            found = result.tombstone == false;
+            break;
+        }
+    }
+    return found;
+}
+
+void DBLSMIndex::find(const DBAttrType &val, DBListTID &tids) {
+    LOG4CXX_INFO(logger,"find()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+
+    tids.clear();
+    memEntry result;
+    if (lookup(val, result)) {
+        LOG4CXX_DEBUG(logger,"Found TID: "+result.tid.toString());
+        tids.push_back(result.tid);
+    }
+
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+}
+
+void DBLSMIndex::insert(const DBAttrType &val, const TID &tid) {
+    LOG4CXX_INFO(logger,"insert()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+    LOG4CXX_DEBUG(logger,"tid: "+tid.toString());
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+
+    //Eindeutigkeit pruefen, negative Anfragen beantworten meist die Bloom-Filter
+    memEntry existing;
+    if (lookup(val, existing))
+        throw DBIndexException("Insert failed, entry already exists with TID "+existing.tid.toString());
+
+    //erst ins Log, dann in die Memtable
+    normalizeKey(val, keyBuf);
+    appendToLog(keyBuf, tid, false);
+    putMemTable(keyBuf, tid, false);
+
+    if (mem.size() >= memTableLimit() || logEntries >= 2 * memTableLimit())
+        flushMemTable();
+
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+}
+
+void DBLSMIndex::remove(const DBAttrType &val, const DBListTID &tid) {
+    LOG4CXX_INFO(logger,"remove()");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+
+    memEntry existing;
+    if (lookup(val, existing) == false) {
+        LOG4CXX_DEBUG(logger,"Given value not found to delete");
+        return;
+    }
+    bool match = false;
+    for (DBListTID::const_iterator i = tid.begin(); i != tid.end() && match == false; ++i)
+        match = *i == existing.tid;
+    if (match == false) {
+        LOG4CXX_DEBUG(logger,"Given TID not found to delete");
+        return;
+    }
+
+    //Tombstone verdeckt aeltere Versionen in den Runs
+    normalizeKey(val, keyBuf);
+    appendToLog(keyBuf, existing.tid, true);
+    putMemTable(keyBuf, existing.tid, true);
+
+    if (mem.size() >= memTableLimit() || logEntries >= 2 * memTableLimit())
+        flushMemTable();
+}
+
+void DBLSMIndex::beginRun(runInfo & run, uint level, uint expectedEntries) {
+    run.level = level;
+    run.entryCnt = 0;
+    run.fenceBlock = noBlock;
+    run.bloomBlock = noBlock;
+    run.bloomBits = max(expectedEntries * bloomBitsPerKey, (uint) 64);
+    run.bloom.assign((run.bloomBits + 7) / 8, 0);
+}
+
+void DBLSMIndex::appendToRun(runInfo & run, vector<char> & page, const char * key, const TID & tid, bool tombstone) {
+    if (page.empty()) {
+        page.assign(DBFileBlock::getBlockSize(), 0);
+        run.fenceKeys.insert(run.fenceKeys.end(), key, key + attrTypeSize);
+    }
+    uint * cnt = (uint *) &page[0];
+    char * ptr = &page[sizeof(uint) + DATA_ENTRY_SIZE * (*cnt)];
+    memcpy(ptr, key, attrTypeSize);
+    memcpy(ptr + attrTypeSize, &tid, sizeof(TID));
+    ptr[attrTypeSize + sizeof(TID)] = tombstone ? 1 : 0;
+    ++*cnt;
+    ++run.entryCnt;
+
+    uint h1, h2;
+    bloomHashes(key, h1, h2);
+    for (uint i = 0; i < bloomHashCnt; ++i) {
+        uint bit = (h1 + i * h2) % run.bloomBits;
+        run.bloom[bit / 8] |= 1 << (bit % 8);
+    }
+
+    if (*cnt == entriesPerDataPage()) {
+        run.fencePages.push_back(writePage(page));
+        page.clear();
+    }
+}
+
+/**
+ * Schreibt die letzte Datenseite sowie Fence- und Bloom-Seiten des Runs.
+ * Ketten werden von hinten aufgebaut, damit jede Seite nur einmal geschrieben wird.
+ */
+void DBLSMIndex::finishRun(runInfo & run, vector<char> & page) {
+    LOG4CXX_INFO(logger,"finishRun()");
+    if (page.empty() == false) {
+        run.fencePages.push_back(writePage(page));
+        page.clear();
+    }
+
+    uint fencePageCnt = (run.fencePages.size() + fencesPerPage() - 1) / fencesPerPage();
+    BlockNo next = noBlock;
+    for (uint p = fencePageCnt; p > 0; --p) {
+        page.assign(DBFileBlock::getBlockSize(), 0);
+        *(BlockNo *) &page[0] = next;
+        uint first = (p - 1) * fencesPerPage();
+        uint cnt = min(fencesPerPage(), (uint) run.fencePages.size() - first);
+        *(uint *) &page[sizeof(BlockNo)] = cnt;
+        char * ptr = &page[FENCE_HEADER_SIZE];
+        for (uint i = first; i < first + cnt; ++i) {
+            memcpy(ptr, &run.fenceKeys[attrTypeSize * i], attrTypeSize);
+            ptr += attrTypeSize;
+            *(BlockNo *) ptr = run.fencePages[i];
+            ptr += sizeof(BlockNo);
+        }
+        next = writePage(page);
+    }
+    run.fenceBlock = next;
+
+    const uint bytesPerPage = DBFileBlock::getBlockSize() - sizeof(BlockNo);
+    uint bloomPageCnt = (run.bloom.size() + bytesPerPage - 1) / bytesPerPage;
+    next = noBlock;
+    for (uint p = bloomPageCnt; p > 0; --p) {
+        page.assign(DBFileBlock::getBlockSize(), 0);
+        *(BlockNo *) &page[0] = next;
+        uint offset = (p - 1) * bytesPerPage;
+        memcpy(&page[sizeof(BlockNo)], &run.bloom[offset], min(bytesPerPage, (uint) run.bloom.size() - offset));
+        next = writePage(page);
+    }
+    run.bloomBlock = next;
+    page.clear();
+
+    LOG4CXX_DEBUG(logger,"New run: level "+TO_STR(run.level)+", entries "+TO_STR(run.entryCnt)+", data pages "+TO_STR(run.fencePages.size()));
+}
+
+void DBLSMIndex::openCursor(runCursor & cursor, const runInfo & run) {
+    cursor.run = &run;
+    cursor.pageIdx = 0;
+    cursor.slot = 0;
+    cursor.cnt = 0;
+    cursor.key = NULL;
+    if (run.fencePages.empty() == false) {
+        loadPage(run.fencePages[0], cursor.page);
+        cursor.cnt = *(uint *) &cursor.page[0];
+        cursor.key = &cursor.page[sizeof(uint)];
+    }
+}
+
+void DBLSMIndex::advanceCursor(runCursor & cursor) {
+    cursor.key = NULL;
+    if (++cursor.slot == cursor.cnt) {
+        cursor.slot = 0;
+        if (++cursor.pageIdx == cursor.run->fencePages.size())
+            return;
+        loadPage(cursor.run->fencePages[cursor.pageIdx], cursor.page);
+        cursor.cnt = *(uint *) &cursor.page[0];
+    }
+    cursor.key = &cursor.page[sizeof(uint) + DATA_ENTRY_SIZE * cursor.slot];
+}
+
+void DBLSMIndex::flushMemTable() {
+    LOG4CXX_INFO(logger,"flushMemTable()");
+    LOG4CXX_DEBUG(logger,"memtable entries: "+TO_STR(mem.size()));
+
+    //ohne aeltere Runs muessen keine Tombstones geschrieben werden
+    bool keepTombstones = runs.empty() == false;
+    runInfo run;
+    vector<char> page;
+    beginRun(run, 0, mem.size());
+    for (memTable::iterator it = mem.begin(); it != mem.end(); ++it) {
+        if (it->second.tombstone && keepTombstones == false)
+            continue;
+        normalizeKey(*it->first, keyBuf);
+        appendToRun(run, page, keyBuf, it->second.tid, it->second.tombstone);
+    }
+    finishRun(run, page);
+    clearMemTable();
+
+    if (run.entryCnt > 0)
+        runs.insert(runs.begin(), run);
+    else
+        dropRun(run);
+    //Run eintragen und Log leeren im selben Metablock
+    dropLog();
+    writeMeta();
+    compact();
+}
+
+/**
+ * Compaction laeuft synchron nach einem Flush, da der Buffermanager keine
+ * Hintergrundthreads kennt: Level 0 wird bei maxLevel0Runs Runs komplett
+ * nach Level 1 gemischt, Level i > 0 bei Ueberschreiten der Kapazitaet nach i+1.
+ */
+void DBLSMIndex::compact() {
+    LOG4CXX_INFO(logger,"compact()");
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        uint level0Runs = 0;
+        for (uint i = 0; i < runs.size() && runs[i].level == 0; ++i)
+            ++level0Runs;
+        if (level0Runs >= maxLevel0Runs) {
+            mergeLevel(0);
+            merged = true;
+            continue;
+        }
+        for (uint i = level0Runs; i < runs.size(); ++i) {
+            if (runs[i].entryCnt > levelCapacity(runs[i].level)) {
+                mergeLevel(runs[i].level);
+                merged = true;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * k-Wege-Mischen aller Runs aus Level level und level+1 zu einem neuen Run in level+1.
+ * Bei gleichen Schluesseln gewinnt der neueste Run (kleinster Index in runs).
+ */
+void DBLSMIndex::mergeLevel(uint level) {
+    LOG4CXX_INFO(logger,"mergeLevel()");
+    LOG4CXX_DEBUG(logger,"level: "+TO_STR(level));
+
+    uint first = runs.size(), last = 0, expected = 0;
+    bool deeperRuns = false;
+    for (uint i = 0; i < runs.size(); ++i) {
+        if (runs[i].level == level || runs[i].level == level + 1) {
+            first = min(first, i);
+            last = i + 1;
+            expected += runs[i].entryCnt;
+        } else if (runs[i].level > level + 1) {
+            deeperRuns = true;
+        }
+    }
+
+    vector<runCursor> cursors(last - first);
+    for (uint i = first; i < last; ++i)
+        openCursor(cursors[i - first], runs[i]);
+
+    runInfo run;
+    vector<char> page;
+    beginRun(run, level + 1, expected);
+    while (true) {
+        int newest = -1;
+        for (uint i = 0; i < cursors.size(); ++i) {
+            if (cursors[i].key != NULL && (newest < 0 || compareKeys(cursors[i].key, cursors[newest].key) < 0))
+                newest = i;
+        }
+        if (newest < 0)
+            break;
+
+        const char * entry = &cursors[newest].page[sizeof(uint) + DATA_ENTRY_SIZE * cursors[newest].slot];
+        TID tid;
+        memcpy(&tid, entry + attrTypeSize, sizeof(TID));
+        bool tombstone = entry[attrTypeSize + sizeof(TID)] != 0;
+        //Tombstones entfallen, wenn es keine aelteren Runs mehr gibt
+        if (tombstone == false || deeperRuns)
+            appendToRun(run, page, entry, tid, tombstone);
+
+        //verdeckte Versionen in aelteren Runs ueberspringen
+        for (uint i = newest + 1; i < cursors.size(); ++i) {
+            if (cursors[i].key != NULL && compareKeys(cursors[i].key, cursors[newest].key) == 0)
+                advanceCursor(cursors[i]);
+        }
+        advanceCursor(cursors[newest]);
+    }
+    finishRun(run, page);
+
+    for (uint i = first; i < last; ++i)
+        dropRun(runs[i]);
+    runs.erase(runs.begin() + first, runs.begin() + last);
+    if (run.entryCnt > 0)
+        runs.insert(runs.begin() + first, run);
+    else
+        dropRun(run);
+    writeMeta();
+}
+
+/**
+ * Haengt eine Aenderung an das Log an. Die Log-Seiten gehen wie alle anderen
+ * Seiten durch den Buffermanager, die Memtable ist damit nicht mehr fluechtig
+ */
+void DBLSMIndex::appendToLog(const char * key, const TID & tid, bool tombstone) {
+    bool full = true;
+    if (logTail != noBlock) {
+        bacbStack.push(bufMgr.fixBlock(file, logTail, LOCK_EXCLUSIVE));
+        full = *LOG_CNT(bacbStack.top().getDataPtr()) == entriesPerLogPage();
+        if (full) {
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+        }
+    }
+    if (full) {
+        BlockNo b = allocPage();
+        if (logTail == noBlock) {
+            *META_LOG_HEAD(bacbStack.top().getDataPtr()) = b;
+            bacbStack.top().setModified();
+        } else {
+            bacbStack.push(bufMgr.fixBlock(file, logTail, LOCK_EXCLUSIVE));
+            *(BlockNo *) bacbStack.top().getDataPtr() = b;
+            bacbStack.top().setModified();
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+        }
+        logTail = b;
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+        *(BlockNo *) bacbStack.top().getDataPtr() = noBlock;
+        *LOG_CNT(bacbStack.top().getDataPtr()) = 0;
+        LOG4CXX_DEBUG(logger,"New log page "+TO_STR(b));
+    }
+
+    char * ptr = bacbStack.top().getDataPtr();
+    uint * cnt = LOG_CNT(ptr);
+    ptr += LOG_HEADER_SIZE + DATA_ENTRY_SIZE * (*cnt);
+    memcpy(ptr, key, attrTypeSize);
+    memcpy(ptr + attrTypeSize, &tid, sizeof(TID));
+    ptr[attrTypeSize + sizeof(TID)] = tombstone ? 1 : 0;
+    ++*cnt;
+    ++logEntries;
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+}
+
+/**
+ * Baut die Memtable beim Oeffnen aus dem Log wieder auf
+ */
+void DBLSMIndex::replayLog() {
+    LOG4CXX_INFO(logger,"replayLog()");
+    vector<char> page;
+    BlockNo b = *META_LOG_HEAD(bacbStack.top().getDataPtr());
+    while (b != noBlock) {
+        loadPage(b, page);
+        logTail = b;
+        b = *(BlockNo *) &page[0];
+        uint cnt = *LOG_CNT(&page[0]);
+        const char * ptr = &page[LOG_HEADER_SIZE];
+        for (uint i = 0; i < cnt; ++i, ptr += DATA_ENTRY_SIZE) {
+            TID tid;
+            memcpy(&tid, ptr + attrTypeSize, sizeof(TID));
+            putMemTable(ptr, tid, ptr[attrTypeSize + sizeof(TID)] != 0);
+        }
+        logEntries += cnt;
+    }
+    LOG4CXX_DEBUG(logger,"Replayed log entries: "+TO_STR(logEntries));
+}
+
+/**
+ * Gibt alle Log-Seiten frei, nachdem die Memtable als Run geschrieben ist
+ */
+void DBLSMIndex::dropLog() {
+    LOG4CXX_INFO(logger,"dropLog()");
+    vector<char> page;
+    BlockNo b = *META_LOG_HEAD(bacbStack.top().getDataPtr());
+    while (b != noBlock) {
+        loadPage(b, page);
+        BlockNo next = *(BlockNo *) &page[0];
+        freePage(b);
+        b = next;
+    }
+    *META_LOG_HEAD(bacbStack.top().getDataPtr()) = noBlock;
+    bacbStack.top().setModified();
+    logTail = noBlock;
+    logEntries = 0;
+}
+
+void DBLSMIndex::unfixBACBs(bool setDirty) {
+    LOG4CXX_INFO(logger,"unfixBACBs()");
+    LOG4CXX_DEBUG(logger,"setDirty: "+TO_STR(setDirty));
+    LOG4CXX_DEBUG(logger,"bacbStack.size()= "+TO_STR(bacbStack.size()));
+    while (bacbStack.empty() == false) {
+        try {
+            if (bacbStack.top().getModified()) {
+                if (setDirty == true)
+                    bacbStack.top().setDirty();
+            }
+            bufMgr.unfixBlock(bacbStack.top());
+        } catch (DBException & e) {
+        }
+        bacbStack.pop();
+    }
+}
+
+int DBLSMIndex::registerClass() {
+    setClassForName("DBLSMIndex", createDBLSMIndex);
+    return 0;
+}
+
+/**
+ * Gerufen von HubDB::Types::getClassForName von DBTypes, um DBIndex zu erstellen
+ * - DBBufferMgr *: Buffermanager
+ * - DBFile *: Dateiobjekt
+ * - attrType: Attributtp
+ * - ModeType: READ, WRITE
+ * - bool: unique Indexattribut
+ */
+extern "C" void * createDBLSMIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBLSMIndex(*bufMgr, *file, attrType, m, unique);
+}
@@ -1,5 +1,12 @@
 #include <hubDB/DBMyIndex.h>
 #include <hubDB/DBException.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <alloca.h>
+#include <algorithm>
 
 using namespace HubDB::Index;
 using namespace HubDB::Exception;
@@ -9,18 +16,123 @@ LoggerPtr DBMyIndex::logger(Logger::getLogger("HubDB.Index.DBMyIndex"));
 // registerClass()-Methode am Ende dieser Datei: macht die Klasse der Factory bekannt
 int rMyIdx = DBMyIndex::registerClass();
 const BlockNo DBMyIndex::metaBlockNo(0);
+const uint DBMyIndex::packedLeafMark(0x80000000);
+const uint DBMyIndex::maxDepth;
+const uint DBMyIndex::filterBitsPerKey(10);
+const uint DBMyIndex::filterHashCnt(7);
+const uint DBMyIndex::extentSize(8);
+const uint DBMyIndex::catchUpRounds(8);
+const uint DBMyIndex::catchUpEntries(256);
+
+namespace {
+    //nimmt nur die erste TID auf, ohne Listenknoten (Index ist unique)
+    struct firstTidSink : public DBMyIndex::tidSink {
+        firstTidSink():found(false){}
+        bool put(const TID & t) {
+            tid = t;
+            found = true;
+            return false;
+        }
+        bool found;
+        TID tid;
+    };
+
+    /**
+     * Schluesseltypen zur Compilezeit
+     * - size: feste Schluessellaenge, 0 = Laenge erst zur Laufzeit bekannt (VCHAR)
+     * - compare: Vergleich serialisierter Schluessel, wird in die Suchkerne inlined
+     */
+    template<enum AttrTypeEnum T> struct keyTraits;
+
+    template<> struct keyTraits<INT> {
+        static const uint size = sizeof(int);
+        static int compare(const char * a, const char * b, uint) {
+            int x, y;
+            memcpy(&x, a, sizeof(int));
+            memcpy(&y, b, sizeof(int));
+            return (y < x) - (x < y);
+        }
+    };
+
+    template<> struct keyTraits<DOUBLE> {
+        static const uint size = sizeof(double);
+        static int compare(const char * a, const char * b, uint) {
+            double x, y;
+            memcpy(&x, a, sizeof(double));
+            memcpy(&y, b, sizeof(double));
+            return (y < x) - (x < y);
+        }
+    };
+
+    template<> struct keyTraits<VCHAR> {
+        static const uint size = 0;
+        static int compare(const char * a, const char * b, uint keySize) {
+            return memcmp(a, b, keySize);
+        }
+    };
+
+    /**
+     * Anzahl der Schluessel <= key in einem inneren Knoten, entspricht der Position des Kindzeigers
+     * keys zeigt auf den ersten Schluessel, Schrittweite Schluessel + BlockNo
+     * verzweigungsfrei, da innere Knoten nur wenige Schluessel haben
+     */
+    template<enum AttrTypeEnum T>
+    uint searchInnerKeys(const char * keys, uint cnt, const char * key, uint keySize) {
+        const uint stride = (keyTraits<T>::size != 0 ? keyTraits<T>::size : keySize) + sizeof(BlockNo);
+        uint n = 0;
+        for (uint i = 0; i < cnt; i++)
+            n += keyTraits<T>::compare(keys + stride * i, key, keySize) <= 0;
+        return n;
+    }
+
+    /**
+     * erste Position mit Schluessel >= key in einem (dekodierten) Blatt, binaere Suche
+     * entries zeigt auf den ersten Eintrag, Schrittweite Schluessel + TID
+     */
+    template<enum AttrTypeEnum T>
+    uint searchLeafKeys(const char * entries, uint cnt, const char * key, uint keySize) {
+        const uint stride = (keyTraits<T>::size != 0 ? keyTraits<T>::size : keySize) + sizeof(TID);
+        uint lo = 0, hi = cnt;
+        while (lo < hi) {
+            uint mid = (lo + hi) / 2;
+            if (keyTraits<T>::compare(entries + stride * mid, key, keySize) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+}
+
 extern "C" void * createDBMyIndex(int nArgs, va_list ap);
+extern "C" void * createDBMyBufferedIndex(int nArgs, va_list ap);
+extern "C" void * createDBMyCompressedIndex(int nArgs, va_list ap);
+extern "C" void * createDBMyPackedIndex(int nArgs, va_list ap);
+extern "C" void * createDBMyMappedIndex(int nArgs, va_list ap);
+extern "C" void * createDBMyCowIndex(int nArgs, va_list ap);
+extern "C" void * createDBMySharedIndex(int nArgs, va_list ap);
+extern "C" void * createDBMyFilteredIndex(int nArgs, va_list ap);
+extern "C" void * createDBMyResidentIndex(int nArgs, va_list ap);
 //TODO: Defininiere Konstante für B+ Baum
 
 
-DBMyIndex::DBMyIndex(DBBufferMgr &bufferMgr, DBFile &file, enum AttrTypeEnum attrType, ModType mode, bool unique)
-        : DBIndex(bufferMgr, file, attrType, mode, unique) {
+DBMyIndex::DBMyIndex(DBBufferMgr &bufferMgr, DBFile &file, enum AttrTypeEnum attrType, ModType mode, bool unique, bool buffered, enum LeafFormat leafFormat, bool mapped, bool copyOnWrite, bool shared, bool filtered, size_t residentLimit)
+        : DBIndex(bufferMgr, file, attrType, mode, unique), buffered(buffered), leafFormat(leafFormat), mappedPtr(NULL),
+          copyOnWrite(copyOnWrite), epoch(0), spareLoaded(false), releaseCount(0), changed(false), mappedLen(0), residentLen(0), shared(shared), sharedRoot(0), sharedDepth(0),
+          filterBits(0), filterKeys(0), filterCapacity(0), filterStamp(0), partial(false), building(false), buildFailed(false) {
     if (logger != NULL) {
         LOG4CXX_INFO(logger,"DBMyIndex()");
     }
 
-    assert(keysPerInnerNode()>1);
-    assert(keysPerLeafNode()>1);
+    //Bitpacking nur fuer ganzzahlige Schluessel
+    if (this->leafFormat == LEAF_PACKED && attrType != INT)
+        this->leafFormat = LEAF_FRONTCODED;
+    //Praefix- und Suffixlaengen stehen in je einem Byte: lange Schluessel bleiben unkomprimiert
+    if (this->leafFormat != LEAF_PLAIN && attrTypeSize >= 256)
+        this->leafFormat = LEAF_PLAIN;
+    //Puffer in inneren Knoten werden in place geaendert, das vertraegt sich nicht mit copy-on-write
+    if (copyOnWrite)
+        this->buffered = false;
 
     if (bufMgr.getBlockCnt(file) == 0) {
         LOG4CXX_DEBUG(logger,"initializeIndex");
@@ -29,6 +141,64 @@ DBMyIndex::DBMyIndex(DBBufferMgr &bufferMgr, DBFile &file, enum AttrTypeEnum att
 
     //fix meta block
     bacbStack.push(bufMgr.fixBlock(file, metaBlockNo, mode == READ ? LOCK_SHARED : LOCK_INTWRITE));
+    //bei bestehendem Index entscheidet der Metablock ueber den Modus
+    this->buffered = *((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+1) != 0;
+    this->leafFormat = (enum LeafFormat) *((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+2);
+    this->copyOnWrite = *((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+3) != 0;
+    epoch = *((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+4);
+    partial = *((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+7) != 0;
+    if (partial) {
+        const uint * text = (const uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+9;
+        predicate.assign((const char *) (text + 1), *text);
+    }
+
+    appendLeaf = 0;
+    appendStamp = 0;
+    appendFenced = false;
+    appendFence.resize(attrTypeSize);
+
+    //Suchkerne einmalig fuer den Schluesseltyp waehlen
+    switch (attrType) {
+    case INT:
+        innerSearch = searchInnerKeys<INT>;
+        leafSearch = searchLeafKeys<INT>;
+        break;
+    case DOUBLE:
+        innerSearch = searchInnerKeys<DOUBLE>;
+        leafSearch = searchLeafKeys<DOUBLE>;
+        break;
+    default:
+        innerSearch = searchInnerKeys<VCHAR>;
+        leafSearch = searchLeafKeys<VCHAR>;
+        break;
+    }
+
+    assert(keysPerInnerNode()>1);
+    assert(keysPerLeafNode()>1);
+    assert(sizeof(uint) + keysPerLeafNode() * (attrTypeSize + sizeof(TID)) <= leafVersionOffset());
+    assert(!this->buffered || msgsPerBuffer()>1);
+    if (this->leafFormat != LEAF_PLAIN && attrTypeSize >= 256) {
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        throw DBIndexException("Compressed leaves require keys shorter than 256 bytes");
+    }
+
+    if (filtered)
+        buildFilter();
+
+    pthread_rwlock_init(&latch, NULL);
+    pthread_mutex_init(&buildLock, NULL);
+    if (shared) {
+        //Wurzel und Tiefe werden unter dem Latch gelesen statt ueber den fixierten Metablock
+        sharedRoot = *(BlockNo *) bacbStack.top().getDataPtr();
+        sharedDepth = *((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo));
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+    } else if (mapped && mode == READ) {
+        //Metablock bleibt geteilt gesperrt, schreibende Zugriffe sind damit ausgeschlossen
+        if (residentLimit == 0 || loadFile(residentLimit) == false)
+            mapFile();
+    }
 
     if (logger != NULL) {
         LOG4CXX_DEBUG(logger,"this:\n"+toString("\t"));
@@ -37,7 +207,29 @@ DBMyIndex::DBMyIndex(DBBufferMgr &bufferMgr, DBFile &file, enum AttrTypeEnum att
 
 DBMyIndex::~DBMyIndex() {
     LOG4CXX_INFO(logger,"~DBMyIndex()");
+    if (mappedPtr != NULL)
+        munmap((void *) mappedPtr, residentLen != 0 ? residentLen : mappedLen);
+    if (retired.empty() == false || spareLoaded || changed) {
+        writeScope scope(*this);
+        if (bacbStack.size() == 1) {
+            //ohne Handle gibt es auch keine Snapshots mehr
+            pinned.clear();
+            if (retired.empty() == false)
+                reclaimPages();
+            if (spareLoaded)
+                saveSparePages();
+            //als letzte Aenderung: steht der Metablock mit Marke in der Datei, ist sie aktuell
+            if (changed) {
+                *((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+8) = 1;
+                bacbStack.top().setModified();
+            }
+        }
+    }
+    if (building)
+        LOG4CXX_WARN(logger,"online build not finished, "+TO_STR(sideLog.size() / (sizeof(char) + attrTypeSize + sizeof(TID)))+" logged changes are discarded");
     unfixBACBs(false);
+    pthread_rwlock_destroy(&latch);
+    pthread_mutex_destroy(&buildLock);
 }
 
 string DBMyIndex::toString(string linePrefix) const {
@@ -56,11 +248,20 @@ void DBMyIndex::initializeIndex() {
         BlockNo * b = (BlockNo *) bacbStack.top().getDataPtr();
         uint * metaPage = (uint *) b + sizeof(BlockNo);
         *metaPage = 0; //depth of tree
+        *(metaPage+1) = buffered ? 1 : 0; //inner nodes carry message buffers
+        *(metaPage+2) = leafFormat; //format of leaf pages
+        *(metaPage+3) = copyOnWrite ? 1 : 0; //paths are copied instead of modified
+        *(metaPage+4) = 0; //copy-on-write epoch
+        *((BlockNo *) (metaPage+5)) = 0; //head of free page list, 0 = empty
+        *(metaPage+6) = 0; //change counter, invalidates Bloom filters of other handles
+        *(metaPage+7) = 0; //partial index, predicate text follows the close mark
+        *(metaPage+8) = 0; //set when a writing handle closes, cleared by every change
 
         bacbStack.push(bufMgr.fixNewBlock(file));
         bacbStack.top().setModified();
         uint * rootCnt = (uint *) bacbStack.top().getDataPtr();
         *rootCnt = 0; //not sure if this is necessary
+        *(rootCnt+1) = 0; //compressed leaves: used bytes
         *b = bacbStack.top().getBlockNo();
 
         LOG4CXX_DEBUG(logger,"Metapage: initial depth "+ TO_STR(*metaPage) +", initial BlockNo "+ TO_STR(*b));
@@ -85,27 +286,137 @@ void DBMyIndex::initializeIndex() {
 
 uint DBMyIndex::keysPerInnerNode() const {
     return 4;
-    //return (DBFileBlock::getBlockSize() - sizeof(uint) - sizeof(BlockNo)) /
+    //return (innerPivotSpace() - sizeof(uint) - sizeof(BlockNo)) /
     //       (DBAttrType::getSize4Type(attrType) + sizeof(BlockNo));
 }
 
 uint DBMyIndex::keysPerLeafNode() const {
     return 4;
-    //return (DBFileBlock::getBlockSize() - sizeof(uint)) /
+    //Versionsstempel am Seitenende abziehen (siehe leafVersionOffset)
+    //return (leafVersionOffset() - sizeof(uint)) /
     //       (DBAttrType::getSize4Type(attrType) + sizeof(TID));
 }
 
+/**
+ * Im buffered mode ist nur die erste Haelfte eines inneren Knotens fuer
+ * Schluessel und Kindzeiger vorgesehen, der Rest nimmt den Nachrichtenpuffer auf
+ */
+uint DBMyIndex::innerPivotSpace() const {
+    return buffered ? DBFileBlock::getBlockSize() / 2 : DBFileBlock::getBlockSize();
+}
+
+//Puffer beginnt direkt hinter dem (maximal gefuellten) Schluesselbereich
+uint DBMyIndex::innerBufferOffset() const {
+    return sizeof(uint) + sizeof(BlockNo) + (attrTypeSize + sizeof(BlockNo)) * keysPerInnerNode();
+}
+
+uint DBMyIndex::msgsPerBuffer() const {
+    return (DBFileBlock::getBlockSize() - innerBufferOffset() - sizeof(uint)) /
+           (attrTypeSize + sizeof(TID) + sizeof(char));
+}
+
 void DBMyIndex::find(const DBAttrType &val, DBListTID &tids) {
-    LOG4CXX_INFO(logger,"find()");
+    tids.clear();
+    tidListSink sink(tids);
+    find(val, sink);
+}
+
+/**
+ * Wie find(), die TIDs gehen aber direkt an den Verbraucher
+ */
+void DBMyIndex::find(const DBAttrType &val, tidSink &sink) {
+    if (shared) {
+        //Schluessel auf dem Stack: parallele Leser teilen sich keinen Puffer
+        char * key = (char *) alloca(attrTypeSize);
+        val.write(key);
+        if (sharedFilterExcludes(key)) {
+            LOG4CXX_DEBUG(logger,"Value excluded by filter");
+            return;
+        }
+        sharedLookup(key, val, sink);
+        return;
+    }
+    lookup(val, sink);
+}
+
+/**
+ * Punktsuche im shared mode: eigener Abstieg unter dem Leselatch ohne
+ * bacbStack und ohne Puffer des Handles. Der Schluessel liegt beim Aufrufer
+ * auf dem Stack, in den Nachrichtenpuffern wird nur nach ihm gesucht, und
+ * komprimierte Blaetter werden nicht dekodiert. Die TID geht erst nach dem
+ * Loesen der Seite an den Verbraucher.
+ */
+void DBMyIndex::sharedLookup(const char * key, const DBAttrType &val, tidSink &sink) {
+    LOG4CXX_INFO(logger,"sharedLookup()");
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const uint msgSize = entrySize + sizeof(char);
+
+    firstTidSink result;
+    {
+        latchScope latch(*this, false);
+        BlockNo b = sharedRoot;
+        char op = MSG_NONE;
+        for (uint d = 0; d < sharedDepth && op == MSG_NONE; d++) {
+            DBBACB bacb = bufMgr.fixBlock(file, b, LOCK_SHARED);
+            const char * page = bacb.getDataPtr();
+            uint cnt = *(const uint *) page;
+            uint child = innerSearch(page + sizeof(uint) + sizeof(BlockNo), cnt, key, attrTypeSize);
+            b = *(const BlockNo *) (page + sizeof(uint) + (sizeof(BlockNo) + attrTypeSize) * child);
+            if (buffered) {
+                //die oberste Nachricht zu key ist die neueste und entscheidet
+                const char * msg = page + innerBufferOffset();
+                uint msgCnt = *(const uint *) msg;
+                msg += sizeof(uint);
+                for (uint i = 0; i < msgCnt && op == MSG_NONE; i++, msg += msgSize) {
+                    if (compareKeys(msg, key) == 0) {
+                        memcpy(&result.tid, msg + attrTypeSize, sizeof(TID));
+                        op = msg[entrySize];
+                    }
+                }
+            }
+            bufMgr.unfixBlock(bacb);
+        }
+
+        if (op != MSG_NONE) {
+            LOG4CXX_DEBUG(logger, op == MSG_INSERT ? "Found TID in buffer" : "Value deleted in buffer");
+            result.found = op == MSG_INSERT;
+        } else {
+            DBBACB bacb = bufMgr.fixBlock(file, b, LOCK_SHARED);
+            const char * page = bacb.getDataPtr();
+            if (leafFormat == LEAF_PLAIN) {
+                uint cnt = *(const uint *) page;
+                const char * entries = page + sizeof(uint);
+                uint pos = leafSearch(entries, cnt, key, attrTypeSize);
+                if (pos < cnt && compareKeys(entries + entrySize * pos, key) == 0) {
+                    memcpy(&result.tid, entries + entrySize * pos + attrTypeSize, sizeof(TID));
+                    result.found = true;
+                }
+            } else if (*((const uint *) page + 1) & packedLeafMark) {
+                findInPackedLeaf(page, val, result);
+            } else {
+                result.found = findInFrontCodedLeaf(page, key, result.tid);
+            }
+            bufMgr.unfixBlock(bacb);
+        }
+    }
+    if (result.found)
+        sink.put(result.tid);
+}
+
+void DBMyIndex::lookup(const DBAttrType &val, tidSink &sink) {
+    LOG4CXX_INFO(logger,"lookup()");
     LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
 
     // ein Block muss geblockt sein
     if (bacbStack.size() != 1)
         throw DBIndexException("BACB Stack is invalid");
-
-    tids.clear();
+    arenaScope scope(arena);
 
     char * metaPtr = bacbStack.top().getDataPtr();
+    if (filterBits != 0 && filterExcludes(keyBytes(val))) {
+        LOG4CXX_DEBUG(logger,"Value excluded by filter");
+        return;
+    }
     BlockNo b = *(BlockNo *) metaPtr;
     uint depth = *((uint *) metaPtr+sizeof(BlockNo));
 
@@ -114,99 +425,406 @@ void DBMyIndex::find(const DBAttrType &val, DBListTID &tids) {
 
     for(int i = 0; i < depth; i++) {
         //do find for inner nodes and set block to new value
-        b = findInInnerNode(val, b);
+        if (buffered) {
+            //die oberste Nachricht zu val ist die neueste und entscheidet
+            bufferMsg msg;
+            b = findInInnerNode(val, b, &msg);
+            if (msg.op == MSG_INSERT) {
+                LOG4CXX_DEBUG(logger, "Found TID in buffer: "+msg.tid.toString());
+                sink.put(msg.tid);
+                return;
+            } else if (msg.op == MSG_DELETE) {
+                LOG4CXX_DEBUG(logger, "Value deleted in buffer");
+                return;
+            }
+        } else {
+            b = findInInnerNode(val, b);
+        }
     }
-    //do find for leaf node, set tids to tid
-    findInLeafNode(val, b, tids);
+    //do find for leaf node, pass tid to sink
+    findInLeafNode(val, b, sink);
 
     if (bacbStack.size() != 1)
         throw DBIndexException("BACB Stack is invalid");
 }
 
-BlockNo DBMyIndex::findInInnerNode(const DBAttrType & val, BlockNo b) {
+BlockNo DBMyIndex::findInInnerNode(const DBAttrType & val, BlockNo b, bufferMsg * msg, bool * rightmost) {
     LOG4CXX_INFO(logger, "findInInnerNode()");
     LOG4CXX_DEBUG(logger, "BlockNo: "+TO_STR(b));
-    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
-    const char * ptr = bacbStack.top().getDataPtr();
+    const char * pagePtr = fixPageForRead(b);
+    const char * ptr = pagePtr;
     uint cnt = *(uint *) ptr;
     if (cnt == 0)
         throw DBIndexException("Empty Inner Node");
     ptr += sizeof(uint);
+    const char * key = keyBytes(val);
 
-    //Sequential search, can be replaced with binary
-    for (uint i = 0; i < cnt; i++) {
-        ptr+=sizeof(BlockNo);
-        DBAttrType * attr = DBAttrType::read(ptr, attrType, &ptr);
-        if (*attr > val) {
-            ptr -= attrTypeSize+sizeof(BlockNo);
-            break;
-        } else if(*attr == val) {
-            break;
-        }
+    //gleiche Schluessel gehen nach rechts
+    uint child = innerSearch(ptr + sizeof(BlockNo), cnt, key, attrTypeSize);
+    ptr += (sizeof(BlockNo) + attrTypeSize) * child;
+    if (rightmost != NULL) {
+        //letzter Kindzeiger: der Schluessel davor ist die untere Grenze des Teilbaums
+        *rightmost = child == cnt;
+        if (*rightmost)
+            memcpy(&appendFence[0], ptr - attrTypeSize, attrTypeSize);
     }
 
     BlockNo result = *((BlockNo *)ptr);
     LOG4CXX_DEBUG(logger, "Found Child BlockNo: "+TO_STR(result));
 
-    bufMgr.unfixBlock(bacbStack.top());
-    bacbStack.pop();
+    if (msg != NULL) {
+        //Nachrichtenpuffer durchsuchen, pro Schluessel gibt es hoechstens eine Nachricht
+        msg->op = MSG_NONE;
+        ptr = pagePtr + innerBufferOffset();
+        uint msgCnt = *(uint *) ptr;
+        ptr += sizeof(uint);
+        for (uint i = 0; i < msgCnt && msg->op == MSG_NONE; i++) {
+            if (compareKeys(ptr, key) == 0) {
+                memcpy(&msg->tid, ptr + attrTypeSize, sizeof(TID));
+                msg->op = ptr[attrTypeSize + sizeof(TID)];
+            }
+            ptr += attrTypeSize + sizeof(TID) + sizeof(char);
+        }
+    }
+
+    unfixPageForRead();
 
     return result;
 }
 
-void DBMyIndex::findInLeafNode(const DBAttrType & val,BlockNo b,list<TID> & tids) {
+void DBMyIndex::findInLeafNode(const DBAttrType & val,BlockNo b,tidSink & sink) {
     LOG4CXX_INFO(logger, "findInLeafNode()");
     LOG4CXX_DEBUG(logger, "BlockNo: "+TO_STR(b));
-    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
-    const char * ptr = bacbStack.top().getDataPtr();
+    const char * ptr = fixPageForRead(b);
+    if (leafFormat != LEAF_PLAIN) {
+        if (*((uint *) ptr + 1) & packedLeafMark) {
+            //gepackte Blaetter werden ohne Dekodieren durchsucht
+            findInPackedLeaf(ptr, val, sink);
+            unfixPageForRead();
+            return;
+        }
+        decodeLeaf(ptr, leafImage);
+        ptr = &leafImage[0];
+    }
     uint cnt = *(uint *) ptr;
-    if (cnt == 0)
+    //im buffered und copy-on-write mode und mit komprimierten Blaettern werden Blaetter beim Loeschen nicht zusammengelegt
+    if (cnt == 0 && buffered == false && copyOnWrite == false && leafFormat == LEAF_PLAIN)
         throw DBIndexException("Empty Leaf Node");
 
     ptr += sizeof(uint);
 
     bool found = 0;
-    //Sequential search, can be replaced with binary
-    for (uint i = 0; i < cnt; i++) {
-        DBAttrType * attr = DBAttrType::read(ptr, attrType, &ptr);
-        if (*attr == val) {
+    const char * key = keyBytes(val);
+    uint pos = leafSearch(ptr, cnt, key, attrTypeSize);
+    ptr += (attrTypeSize + sizeof(TID)) * pos;
+    for (uint i = pos; i < cnt; i++) {
+        int cmp = compareKeys(ptr, key);
+        ptr += attrTypeSize;
+        if (cmp == 0) {
             TID result = *(TID *) ptr;
             LOG4CXX_DEBUG(logger, "Found TID: "+result.toString());
-            tids.push_back(result);
+            sink.put(result);
             found = 1;
             break;
         }
         ptr += sizeof(TID);
     }
 
-    bufMgr.unfixBlock(bacbStack.top());
-    bacbStack.pop();
+    unfixPageForRead();
 
     if(found == 0){
         LOG4CXX_DEBUG(logger, "Value not found");
     }
 }
 
+const char * DBMyIndex::fixPageForRead(BlockNo b) {
+    if (mappedPtr != NULL) {
+        if ((size_t) b * DBFileBlock::getBlockSize() >= mappedLen)
+            throw DBIndexException("BlockNo "+TO_STR(b)+" outside of mapped index file");
+        return mappedPtr + (size_t) b * DBFileBlock::getBlockSize();
+    }
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+    return bacbStack.top().getDataPtr();
+}
+
+void DBMyIndex::unfixPageForRead() {
+    if (mappedPtr != NULL)
+        return;
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+}
+
+/**
+ * Read-only Modus: die Indexdatei wird direkt in den Speicher gemappt, find()
+ * greift dann ohne Buffermanager auf die Seiten zu. Setzt voraus, dass alle
+ * Aenderungen bereits in die Datei geschrieben wurden; das wird allein am
+ * Metablock geprueft (siehe imageIsCurrent). Klappt das Mappen nicht, bleibt es
+ * beim Zugriff ueber den Buffermanager.
+ */
+void DBMyIndex::mapFile() {
+    LOG4CXX_INFO(logger,"mapFile()");
+    size_t len = (size_t) bufMgr.getBlockCnt(file) * DBFileBlock::getBlockSize();
+    int fd = open(file.getFileName().c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG4CXX_WARN(logger,"could not open "+file.getFileName()+" for mapping, using buffer manager");
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < len) {
+        LOG4CXX_WARN(logger,"index file "+file.getFileName()+" is not written back completely, using buffer manager");
+        close(fd);
+        return;
+    }
+    void * ptr = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        LOG4CXX_WARN(logger,"mmap failed for "+file.getFileName()+", using buffer manager");
+        return;
+    }
+    if (imageIsCurrent((const char *) ptr) == false) {
+        LOG4CXX_WARN(logger,"index file "+file.getFileName()+" is not closed cleanly or older than the buffered pages, using buffer manager");
+        munmap(ptr, len);
+        return;
+    }
+    mappedPtr = (const char *) ptr;
+    mappedLen = len;
+    //Blaetter werden zufaellig gelesen, innere Knoten bei jeder Suche
+    madvise(ptr, len, MADV_RANDOM);
+    adviseInnerNodes();
+    LOG4CXX_DEBUG(logger,"Mapped "+TO_STR(len)+" bytes");
+}
+
+/**
+ * Read-only Modus mit eigener Kopie: die Indexdatei wird mit O_DIRECT am Page
+ * Cache vorbei in einen zusammenhaengenden, ausgerichteten Bereich gelesen, der
+ * moeglichst aus Huge Pages besteht (MAP_HUGETLB, sonst transparente Huge
+ * Pages). Jede Seite liegt so nur einmal im Speicher, und Suchen brauchen nur
+ * wenige TLB-Eintraege. Der Bereich belegt fest die auf Huge Pages gerundete
+ * Dateigroesse; ist das mehr als limit, wird stattdessen gemappt (false).
+ * Ist die Kopie nicht aktuell (siehe imageIsCurrent), waere es die gemappte
+ * Datei ebenso; dann bleibt es beim Buffermanager (true ohne geladene Kopie).
+ */
+bool DBMyIndex::loadFile(size_t limit) {
+    LOG4CXX_INFO(logger,"loadFile()");
+    const size_t hugePageSize = 2 * 1024 * 1024;
+    const size_t chunkSize = 1024 * 1024;
+    size_t len = (size_t) bufMgr.getBlockCnt(file) * DBFileBlock::getBlockSize();
+    size_t regionLen = (len + hugePageSize - 1) & ~(hugePageSize - 1);
+    if (regionLen > limit) {
+        LOG4CXX_WARN(logger,"index file "+file.getFileName()+" needs "+TO_STR(regionLen)+" bytes, limit is "+TO_STR(limit)+", mapping instead");
+        return false;
+    }
+    bool direct = true;
+    int fd = open(file.getFileName().c_str(), O_RDONLY | O_DIRECT);
+    if (fd < 0) {
+        direct = false;
+        fd = open(file.getFileName().c_str(), O_RDONLY);
+    }
+    if (fd < 0) {
+        LOG4CXX_WARN(logger,"could not open "+file.getFileName()+" for loading");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < len) {
+        LOG4CXX_WARN(logger,"index file "+file.getFileName()+" is not written back completely");
+        close(fd);
+        return false;
+    }
+
+    bool huge = true;
+    void * ptr = mmap(NULL, regionLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr == MAP_FAILED) {
+        huge = false;
+        ptr = mmap(NULL, regionLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr != MAP_FAILED)
+            madvise(ptr, regionLen, MADV_HUGEPAGE);
+    }
+    if (ptr == MAP_FAILED) {
+        LOG4CXX_WARN(logger,"could not allocate "+TO_STR(regionLen)+" bytes for "+file.getFileName());
+        close(fd);
+        return false;
+    }
+
+    //O_DIRECT: Puffer, Offset und Laenge sind Vielfache von chunkSize, nur der letzte Lesevorgang ist kuerzer
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = pread(fd, (char *) ptr + done, min(chunkSize, regionLen - done), done);
+        if (n < 0 && direct) {
+            //Dateisystem ohne O_DIRECT
+            close(fd);
+            direct = false;
+            fd = open(file.getFileName().c_str(), O_RDONLY);
+            if (fd < 0)
+                break;
+            continue;
+        }
+        if (n <= 0)
+            break;
+        done += n;
+    }
+    if (done < len) {
+        LOG4CXX_WARN(logger,"could not read "+file.getFileName()+", mapping instead");
+        if (fd >= 0)
+            close(fd);
+        munmap(ptr, regionLen);
+        return false;
+    }
+    //ohne O_DIRECT wenigstens die Kopie im Page Cache wieder freigeben
+    if (direct == false)
+        posix_fadvise(fd, 0, len, POSIX_FADV_DONTNEED);
+    close(fd);
+    if (imageIsCurrent((const char *) ptr) == false) {
+        LOG4CXX_WARN(logger,"index file "+file.getFileName()+" is not closed cleanly or older than the buffered pages, using buffer manager");
+        munmap(ptr, regionLen);
+        return true;
+    }
+    mprotect(ptr, regionLen, PROT_READ);
+
+    mappedPtr = (const char *) ptr;
+    mappedLen = len;
+    residentLen = regionLen;
+    LOG4CXX_DEBUG(logger,"Loaded "+TO_STR(len)+" bytes"+(direct ? " with O_DIRECT" : "")+(huge ? " into huge pages" : ""));
+    return true;
+}
+
+/**
+ * Prueft, ob die Kopie image der Indexdatei aktuell ist, ohne weitere Seiten
+ * ueber den Buffermanager zu lesen: ein schreibender Handle setzt beim
+ * Schliessen als letzte Aenderung eine Marke im Metablock, jede Aenderung
+ * loescht sie wieder (countChange). Traegt der Metablock der Kopie die Marke
+ * und stimmt er mit dem fixierten Rahmen ueberein, wurde seit dem
+ * Zurueckschreiben nichts mehr geaendert.
+ */
+bool DBMyIndex::imageIsCurrent(const char * image) {
+    const size_t blockSize = DBFileBlock::getBlockSize();
+    const char * metaImage = image + metaBlockNo * blockSize;
+    if (*((const uint *) metaImage+sizeof(BlockNo)+8) == 0)
+        return false;
+    //der Metablock ist bereits fixiert
+    return memcmp(bacbStack.top().getDataPtr(), metaImage, blockSize) == 0;
+}
+
+/**
+ * Innere Knoten ebenenweise ab der Wurzel vorab einlesen lassen
+ */
+void DBMyIndex::adviseInnerNodes() {
+    const char * metaPtr = bacbStack.top().getDataPtr();
+    uint depth = *((uint *) metaPtr+sizeof(BlockNo));
+    const size_t osPageSize = sysconf(_SC_PAGESIZE);
+    vector<BlockNo> level(1, *(BlockNo *) metaPtr);
+    for (uint d = 0; d < depth; d++) {
+        vector<BlockNo> next;
+        for (uint i = 0; i < level.size(); i++) {
+            const char * page = fixPageForRead(level[i]);
+            size_t start = ((size_t) page) & ~(osPageSize - 1);
+            madvise((void *) start, (size_t) page + DBFileBlock::getBlockSize() - start, MADV_WILLNEED);
+            uint cnt = *(const uint *) page;
+            const char * ptr = page + sizeof(uint);
+            for (uint k = 0; k <= cnt; k++) {
+                next.push_back(*(const BlockNo *) ptr);
+                ptr += sizeof(BlockNo) + attrTypeSize;
+            }
+        }
+        level.swap(next);
+    }
+}
+
 void DBMyIndex::insert(const DBAttrType &val, const TID &tid) {
+    if (partial)
+        throw DBIndexException("Partial index needs the predicate result of the tuple");
+    insert(val, tid, true);
+}
+
+/**
+ * Einfuegen mit dem vom Aufrufer auf dem Tupel ausgewerteten Praedikat;
+ * beim partiellen Index wird ein nicht qualifizierendes Tupel nicht indexiert
+ * und auch nicht ins Nebenprotokoll des Online-Aufbaus geschrieben.
+ */
+void DBMyIndex::insert(const DBAttrType &val, const TID &tid, bool qualifies) {
     LOG4CXX_INFO(logger,"insert()");
     LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
     LOG4CXX_DEBUG(logger,"tid: "+tid.toString());
+    if (partial && qualifies == false) {
+        LOG4CXX_DEBUG(logger,"Tuple does not qualify for the partial index, ignored");
+        return;
+    }
+    if (logChange(MSG_INSERT, val, tid))
+        return;
+    writeScope scope(*this);
 
     // ein Block muss geblockt sein
     if (bacbStack.size() != 1)
         throw DBIndexException("BACB Stack is invalid");
+    if (mappedPtr != NULL)
+        throw DBIndexException("Index is mapped read only");
     if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
         bufMgr.upgradeToExclusive(bacbStack.top());
+    loadSparePages();
+    arenaScope opScope(arena);
+    insertEntry(val, tid);
+
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+}
+
+void DBMyIndex::insertEntry(const DBAttrType &val, const TID &tid) {
+    if (copyOnWrite) {
+        //vor dem Kopieren pruefen, damit kein halb kopierter Pfad entsteht
+        firstTidSink existing;
+        lookup(val, existing);
+        if (existing.found)
+            throw DBIndexException("Insert failed, entry already exists with TID "+existing.tid.toString());
+        copyPath(val);
+        insertIntoTree(val, tid);
+        commitCopy();
+    } else if (buffered) {
+        //Eindeutigkeit: der Bloom-Filter schliesst neue Schluessel meist ohne Lesen
+        //des Pfads aus, nur bei einem Treffer wird gesucht (inkl. Puffer).
+        //Schreiben und Splitten der Blaetter passiert gebuendelt beim Leeren der Puffer
+        if (filterExcludes(keyBytes(val)) == false) {
+            firstTidSink existing;
+            lookup(val, existing);
+            if (existing.found)
+                throw DBIndexException("Insert failed, entry already exists with TID "+existing.tid.toString());
+        }
+        deliverMessage(val, MSG_INSERT, tid);
+    } else {
+        insertIntoTree(val, tid);
+    }
+
+    countChange();
+    if (filterBits != 0) {
+        if (++filterKeys > filterCapacity) {
+            buildFilter();
+        } else {
+            uint h1, h2;
+            filterHashes(keyBytes(val), h1, h2);
+            filterAdd(h1, h2);
+        }
+    }
+}
+
+void DBMyIndex::insertIntoTree(const DBAttrType &val, const TID &tid) {
+    LOG4CXX_INFO(logger,"insertIntoTree()");
+
+    //monoton steigende Schluessel ohne Abstieg an das rechteste Blatt anhaengen
+    bool rightmost = buffered == false && copyOnWrite == false && leafFormat == LEAF_PLAIN;
+    if (rightmost && appendLeaf != 0 && appendToRightmostLeaf(val, tid))
+        return;
 
     //Find path to insertion point in leaf node
     char * metaPtr = bacbStack.top().getDataPtr();
-    stack<BlockNo> blocks;
+    pathStack blocks;
     BlockNo b = *(BlockNo *) metaPtr;
     blocks.push(b);
     uint depth = *((uint *) metaPtr+sizeof(BlockNo));
     LOG4CXX_DEBUG(logger,"Tree Depth: "+TO_STR(depth));
+    //der Abstieg ueberschreibt die gemerkte Grenze
+    if (rightmost)
+        appendLeaf = 0;
+    appendFenced = rightmost && depth > 0;
     for(int i = 0; i < depth; i++) {
-        b = findInInnerNode(val, b);
+        b = findInInnerNode(val, b, NULL, rightmost ? &rightmost : NULL);
         blocks.push(b);
     }
 
@@ -217,19 +835,37 @@ void DBMyIndex::insert(const DBAttrType &val, const TID &tid) {
     if(splitResult.splitHappens) {
         LOG4CXX_DEBUG(logger, "Leaf Node "+TO_STR(leaf)+" was split, new Block "+TO_STR(splitResult.newBlockNo)+" was created");
     }
+    if (rightmost) {
+        //nach einem Split ist die neue (rechte) Seite das rechteste Blatt
+        if (splitResult.splitHappens) {
+            leaf = splitResult.newBlockNo;
+            memcpy(&appendFence[0], splitResult.newKey, attrTypeSize);
+            appendFenced = true;
+        }
+        rememberRightmostLeaf(leaf);
+    }
+    propagateSplit(blocks, splitResult);
+}
+
+/**
+ * Traegt einen Split in die Knoten auf blocks (oben der Elternknoten des
+ * geteilten Knotens) ein und setzt ihn nach oben fort, ggf. bis zu einer neuen Wurzel
+ */
+void DBMyIndex::propagateSplit(pathStack & blocks, splitInfo splitResult) {
+    char * metaPtr = bacbStack.top().getDataPtr();
     while(splitResult.splitHappens && !blocks.empty()) {
         BlockNo inner = blocks.top();
         blocks.pop();
-        splitResult = insertIntoInner(inner, *splitResult.newKey, splitResult.newBlockNo);
+        splitResult = insertIntoInner(inner, splitResult.newKey, splitResult.newBlockNo);
         if(splitResult.splitHappens) {
-            LOG4CXX_DEBUG(logger, "Inner Node "+TO_STR(leaf)+" was split, new Block "+TO_STR(splitResult.newBlockNo)+" was created");
+            LOG4CXX_DEBUG(logger, "Inner Node "+TO_STR(inner)+" was split, new Block "+TO_STR(splitResult.newBlockNo)+" was created");
         }
     }
 
     if(splitResult.splitHappens && blocks.empty()) {
         //create new root page
         LOG4CXX_DEBUG(logger,"Root was split, initializing new Root Page");
-        bacbStack.push(bufMgr.fixNewBlock(file));
+        bacbStack.push(fixNewPage());
         BlockNo newRootBlockNo = bacbStack.top().getBlockNo();
         LOG4CXX_DEBUG(logger,"New Root BlockNo: " + TO_STR(newRootBlockNo));
         char * newFilePtr = bacbStack.top().getDataPtr();
@@ -241,11 +877,16 @@ void DBMyIndex::insert(const DBAttrType &val, const TID &tid) {
         *newBlock = *(BlockNo *) metaPtr; //root node
         LOG4CXX_DEBUG(logger,"New Root Left Node BlockNo: " + TO_STR(*newBlock));
         newFilePtr += sizeof(BlockNo);
-        newFilePtr = (*splitResult.newKey).write(newFilePtr);
-        LOG4CXX_DEBUG(logger,"New Root Key: " + (*splitResult.newKey).toString());
+        memcpy(newFilePtr, splitResult.newKey, attrTypeSize);
+        newFilePtr += attrTypeSize;
+        LOG4CXX_DEBUG(logger,"New Root Key: " + keyToString(splitResult.newKey));
         newBlock = (BlockNo *) newFilePtr;
         *newBlock = splitResult.newBlockNo;
         LOG4CXX_DEBUG(logger,"New Root Right Node BlockNo: " + TO_STR(*newBlock));
+        if (buffered) {
+            //neue Wurzel beginnt mit leerem Puffer
+            *(uint *) (bacbStack.top().getDataPtr() + innerBufferOffset()) = 0;
+        }
         bacbStack.top().setModified();
         bufMgr.unfixBlock(bacbStack.top());
         bacbStack.pop();
@@ -260,15 +901,15 @@ void DBMyIndex::insert(const DBAttrType &val, const TID &tid) {
         LOG4CXX_DEBUG(logger,"New Depth in Metapage: "+TO_STR(*depthPtr));
         bacbStack.top().setModified();
     }
-
-    if (bacbStack.size() != 1)
-        throw DBIndexException("BACB Stack is invalid");
 }
 
 DBMyIndex::splitInfo DBMyIndex::insertIntoLeaf(const BlockNo b, const DBAttrType &val, const TID &tid) {
     LOG4CXX_INFO(logger,"insertIntoLeaf()");
     LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b));
 
+    if (leafFormat != LEAF_PLAIN)
+        return insertIntoCompressedLeaf(b, val, tid);
+
     splitInfo returnObject;
     returnObject.splitHappens = false;
 
@@ -278,20 +919,20 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoLeaf(const BlockNo b, const DBAttrType
     LOG4CXX_DEBUG(logger, "Keys before Insert: "+TO_STR(*cnt));
     ptr += sizeof(uint);
 
-    uint pos = 0;
+    const char * key = keyBytes(val);
+    uint pos = leafSearch(ptr, *cnt, key, attrTypeSize);
+    ptr += (attrTypeSize + sizeof(TID)) * pos;
     for(; pos < *cnt; pos++) {
-        DBAttrType * attr = DBAttrType::read(ptr, attrType, &ptr);
-        if (*attr > val) {
+        int cmp = compareKeys(ptr, key);
+        if (cmp > 0) {
             break;
-        } else if (*attr == val) {
-            TID * tidPtr = (TID *) ptr;
-            throw DBIndexException("Insert failed, entry already exists with TID "+(*tidPtr).toString());
-            /* TID * tidPtr = (TID *) ptr;
-            *tidPtr = tid;
-            bacbStack.top().setModified();
+        }
+        ptr += attrTypeSize;
+        if (cmp == 0) {
+            TID existing = *(TID *) ptr;
             bufMgr.unfixBlock(bacbStack.top());
-            bacbStack.pop(); */
-            //return returnObject;
+            bacbStack.pop();
+            throw DBIndexException("Insert failed, entry already exists with TID "+existing.toString());
         }
         ptr += sizeof(TID);
     }
@@ -303,12 +944,14 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoLeaf(const BlockNo b, const DBAttrType
 
         returnObject.splitHappens = true;
         const char * ptrOld = bacbStack.top().getDataPtr();
-        uint keysToMove = keysPerLeafNode()/2;
+        //Einfuegen am Ende (aufsteigende Schluessel): altes Blatt bleibt voll, neues beginnt leer
+        bool append = pos == *cnt;
+        uint keysToMove = append ? 0 : keysPerLeafNode()/2;
         LOG4CXX_DEBUG(logger,"KeysToMove: "+TO_STR(keysToMove));
         *cnt -= keysToMove;
         ptrOld += sizeof(uint) + (sizeof(TID)+ attrTypeSize) * *cnt;
 
-        bacbStack.push(bufMgr.fixNewBlock(file));
+        bacbStack.push(fixNewPage(b));
         char * ptrNew = bacbStack.top().getDataPtr();
         returnObject.newBlockNo = bacbStack.top().getBlockNo();
         LOG4CXX_DEBUG(logger,"New Leaf Node BlockNo: " + TO_STR(returnObject.newBlockNo));
@@ -317,12 +960,15 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoLeaf(const BlockNo b, const DBAttrType
         *cntNew = keysToMove;
         ptrNew+=sizeof(uint);
         memcpy(ptrNew, ptrOld, (sizeof(TID)+ attrTypeSize)*keysToMove);
-        returnObject.newKey = DBAttrType::read(ptrNew, attrType);
-        LOG4CXX_DEBUG(logger,"New Leaf Node Key: " + returnObject.newKey->toString());
+        char * newKey = arena.alloc(attrTypeSize);
+        memcpy(newKey, append ? key : ptrNew, attrTypeSize);
+        returnObject.newKey = newKey;
+        LOG4CXX_DEBUG(logger,"New Leaf Node Key: " + keyToString(returnObject.newKey));
 
-        if(pos <= *cnt) {
+        if(append == false && pos <= *cnt) {
             //insert in left node
             LOG4CXX_DEBUG(logger,"Insert into old (left) leaf node");
+            stampLeaf(bacbStack.top().getDataPtr());
             bacbStack.top().setModified();
             bufMgr.unfixBlock(bacbStack.top());
             bacbStack.pop();
@@ -342,7 +988,8 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoLeaf(const BlockNo b, const DBAttrType
         char * to = from + sizeof(TID) + attrTypeSize;
         memmove(to, from, (sizeof(TID) + attrTypeSize) * (*cntPtr - pos));
     }
-    from = val.write(from);
+    memcpy(from, key, attrTypeSize);
+    from += attrTypeSize;
     TID * tidPtr = (TID *) from;
     *tidPtr = tid;
     *cntPtr = *cntPtr+1;
@@ -350,10 +997,12 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoLeaf(const BlockNo b, const DBAttrType
 
 
     if(unfixNewNode) {
+        stampLeaf(bacbStack.top().getDataPtr());
         bacbStack.top().setModified();
         bufMgr.unfixBlock(bacbStack.top());
         bacbStack.pop();
     }
+    stampLeaf(bacbStack.top().getDataPtr());
     bacbStack.top().setModified();
     bufMgr.unfixBlock(bacbStack.top());
     bacbStack.pop();
@@ -361,7 +1010,51 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoLeaf(const BlockNo b, const DBAttrType
     return returnObject;
 }
 
-DBMyIndex::splitInfo DBMyIndex::insertIntoInner(const BlockNo b, const DBAttrType &val, const BlockNo &newBlockNo) {
+/**
+ * Append-Pfad fuer monoton steigende Schluessel: Eintrag direkt an das zuletzt bekannte
+ * rechteste Blatt anhaengen. Gueltig nur, solange der Versionsstempel des Blatts
+ * unveraendert ist, der Schluessel nicht unter dessen unterer Grenze liegt, er groesser
+ * als der letzte Eintrag ist und das Blatt nicht voll ist; sonst normaler Abstieg.
+ */
+bool DBMyIndex::appendToRightmostLeaf(const DBAttrType &val, const TID &tid) {
+    LOG4CXX_INFO(logger,"appendToRightmostLeaf()");
+    const char * key = keyBytes(val);
+    if (appendFenced && compareKeys(key, &appendFence[0]) < 0)
+        return false;
+
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    bacbStack.push(bufMgr.fixBlock(file, appendLeaf, LOCK_EXCLUSIVE));
+    char * page = bacbStack.top().getDataPtr();
+    uint * cnt = (uint *) page;
+    char * end = page + sizeof(uint) + entrySize * *cnt;
+    bool appended = false;
+    if (*(uint *) (page + leafVersionOffset()) != appendStamp) {
+        LOG4CXX_DEBUG(logger,"Rightmost leaf "+TO_STR(appendLeaf)+" changed");
+        appendLeaf = 0;
+    } else if (*cnt < keysPerLeafNode() && (*cnt == 0 || compareKeys(end - entrySize, key) < 0)) {
+        memcpy(end, key, attrTypeSize);
+        memcpy(end + attrTypeSize, &tid, sizeof(TID));
+        ++*cnt;
+        stampLeaf(page);
+        appendStamp = *(uint *) (page + leafVersionOffset());
+        bacbStack.top().setModified();
+        appended = true;
+        LOG4CXX_DEBUG(logger,"Appended to rightmost leaf "+TO_STR(appendLeaf));
+    }
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    return appended;
+}
+
+void DBMyIndex::rememberRightmostLeaf(BlockNo leaf) {
+    bacbStack.push(bufMgr.fixBlock(file, leaf, LOCK_SHARED));
+    appendStamp = *(uint *) (bacbStack.top().getDataPtr() + leafVersionOffset());
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    appendLeaf = leaf;
+}
+
+DBMyIndex::splitInfo DBMyIndex::insertIntoInner(const BlockNo b, const char * key, const BlockNo &newBlockNo) {
     LOG4CXX_INFO(logger,"insertIntoInner()");
     LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b));
     splitInfo returnObject;
@@ -373,15 +1066,8 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoInner(const BlockNo b, const DBAttrTyp
     LOG4CXX_DEBUG(logger, "Keys before Insert: "+TO_STR(*cnt));
     ptr += sizeof(uint) + sizeof(BlockNo);
 
-    //Linear Search for Insert Position
-    uint pos = 0;
-    for(; pos < *cnt; pos++) {
-        DBAttrType * attr = DBAttrType::read(ptr, attrType, &ptr);
-        if (*attr > val) {
-            break;
-        }
-        ptr += sizeof(BlockNo);
-    }
+    uint pos = innerSearch(ptr, *cnt, key, attrTypeSize);
+    ptr += (attrTypeSize + sizeof(BlockNo)) * pos;
     LOG4CXX_DEBUG(logger, "Insert Position: "+TO_STR(pos));
 
     //if block is full, split
@@ -390,13 +1076,14 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoInner(const BlockNo b, const DBAttrTyp
         LOG4CXX_DEBUG(logger,"Inner Node full, splitting");
         returnObject.splitHappens = true;
         const char * ptrOld = bacbStack.top().getDataPtr();
-        *cnt = keysPerInnerNode() / 2;
+        //Einfuegen am Ende: links bleiben alle Schluessel bis auf den hochgereichten
+        *cnt = pos == *cnt ? keysPerInnerNode() - 1 : keysPerInnerNode() / 2;
         LOG4CXX_DEBUG(logger,"Keys in Left Node: "+TO_STR(*cnt));
-        uint keysToMove = keysPerInnerNode() - keysPerInnerNode()/2 - 1;
+        uint keysToMove = keysPerInnerNode() - *cnt - 1;
         LOG4CXX_DEBUG(logger,"Keys in Right Node: "+TO_STR(keysToMove));
         ptrOld += sizeof(uint) + (sizeof(BlockNo)+ attrTypeSize) * ((*cnt)+1);
 
-        bacbStack.push(bufMgr.fixNewBlock(file));
+        bacbStack.push(fixNewPage(b));
         char * ptrNew = bacbStack.top().getDataPtr();
         returnObject.newBlockNo = bacbStack.top().getBlockNo();
         LOG4CXX_DEBUG(logger,"New Inner Node BlockNo: " + TO_STR(returnObject.newBlockNo));
@@ -406,9 +1093,12 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoInner(const BlockNo b, const DBAttrTyp
         memcpy(ptrNew, ptrOld, sizeof(BlockNo) +(sizeof(BlockNo)+ attrTypeSize)*keysToMove);
 
         ptrOld -= attrTypeSize;
-        returnObject.newKey = DBAttrType::read(ptrOld, attrType);
-        LOG4CXX_DEBUG(logger,"New Inner Node Key: " + returnObject.newKey->toString());
-
+        char * newKey = arena.alloc(attrTypeSize);
+        memcpy(newKey, ptrOld, attrTypeSize);
+        returnObject.newKey = newKey;
+        LOG4CXX_DEBUG(logger,"New Inner Node Key: " + keyToString(returnObject.newKey));
+        if (buffered)
+            splitBuffer((char *) cnt, bacbStack.top().getDataPtr(), returnObject.newKey);
 
         if(pos <= *cnt) {
             LOG4CXX_DEBUG(logger,"Insert into old (left) inner node");
@@ -432,7 +1122,8 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoInner(const BlockNo b, const DBAttrTyp
         char * to = from + sizeof(BlockNo) + attrTypeSize;
         memmove(to, from, (sizeof(BlockNo) + attrTypeSize) * (*cntPtr - pos));
     }
-    from = val.write(from);
+    memcpy(from, key, attrTypeSize);
+    from += attrTypeSize;
     BlockNo * blockNoPtr = (BlockNo *) from;
     *blockNoPtr = newBlockNo;
     *cntPtr = *cntPtr+1;
@@ -451,23 +1142,79 @@ DBMyIndex::splitInfo DBMyIndex::insertIntoInner(const BlockNo b, const DBAttrTyp
 }
 
 void DBMyIndex::remove(const DBAttrType &val, const DBListTID &tid) {
+    if (partial)
+        throw DBIndexException("Partial index needs the predicate result of the tuple");
+    remove(val, tid, true);
+}
+
+/**
+ * Loeschen mit dem Praedikat des alten Tupels; hat es beim partiellen Index
+ * nicht qualifiziert, steht es nicht im Index und es gibt nichts zu tun.
+ */
+void DBMyIndex::remove(const DBAttrType &val, const DBListTID &tid, bool qualifies) {
     LOG4CXX_INFO(logger,"remove()");
     LOG4CXX_DEBUG(logger,"val: "+val.toString());
+    if (partial && qualifies == false) {
+        LOG4CXX_DEBUG(logger,"Tuple does not qualify for the partial index, ignored");
+        return;
+    }
+
+    //index is unique, no multiple TIDs
+    if(tid.size() > 1) {
+        throw DBIndexException("Unique Index Only, no multiple TID delete");
+    }
+    if (tid.empty() == false && logChange(MSG_DELETE, val, tid.front()))
+        return;
+    writeScope scope(*this);
 
     // ein Block muss geblockt sein
     if (bacbStack.size() != 1)
         throw DBIndexException("BACB Stack is invalid");
+    if (mappedPtr != NULL)
+        throw DBIndexException("Index is mapped read only");
     if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
         bufMgr.upgradeToExclusive(bacbStack.top());
+    loadSparePages();
+    arenaScope opScope(arena);
+    removeEntry(val, tid);
+}
 
-    //index is unique, no multiple TIDs
-    if(tid.size() > 1) {
-        throw DBIndexException("Unique Index Only, no multiple TID delete");
+void DBMyIndex::removeEntry(const DBAttrType &val, const DBListTID &tid) {
+    if (buffered) {
+        //nur loeschen, wenn der aktuelle Stand (inkl. Puffer) die TID enthaelt;
+        //die Delete-Nachricht entfernt den Schluessel dann unabhaengig von der TID.
+        //Fehlende Schluessel schliesst meist schon der Bloom-Filter aus
+        firstTidSink existing;
+        if (tid.empty() == false && filterExcludes(keyBytes(val)) == false)
+            lookup(val, existing);
+        if (existing.found == false || !(existing.tid == tid.front())) {
+            LOG4CXX_DEBUG(logger, "Given value not found to delete");
+            return;
+        }
+        countChange();
+        deliverMessage(val, MSG_DELETE, tid.front());
+        return;
+    }
+
+    //geloeschte Schluessel bleiben im Bloom-Filter, bis er neu aufgebaut wird
+    countChange();
+
+    if (copyOnWrite) {
+        //Blaetter werden nicht zusammengelegt, es aendert sich nur der kopierte Pfad
+        firstTidSink existing;
+        lookup(val, existing);
+        if (existing.found == false || tid.empty() || !(existing.tid == tid.front())) {
+            LOG4CXX_DEBUG(logger, "Given value not found to delete");
+            return;
+        }
+        removeFromLeafNode(copyPath(val), val, tid);
+        commitCopy();
+        return;
     }
 
     //Find path to insertion point in leaf node
     char * metaPtr = bacbStack.top().getDataPtr();
-    stack<BlockNo> blocks;
+    pathStack blocks;
     BlockNo b = *(BlockNo *) metaPtr;
     blocks.push(b);
     uint depth = *((uint *) metaPtr+sizeof(BlockNo));
@@ -499,18 +1246,27 @@ bool DBMyIndex::removeFromLeafNode(const BlockNo b, const DBAttrType &val, const
 
     bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
     const char * ptr = bacbStack.top().getDataPtr();
+    vector<char> & image = leafImage;
+    if (leafFormat != LEAF_PLAIN) {
+        decodeLeaf(ptr, image);
+        ptr = &image[0];
+    }
     uint * cnt = (uint *) ptr;
     LOG4CXX_DEBUG(logger, "Keys before Delete: "+TO_STR(*cnt));
     ptr += sizeof(uint);
 
-    uint pos = 0;
     bool deleted = false;
+    const char * key = keyBytes(val);
+    uint pos = leafSearch(ptr, *cnt, key, attrTypeSize);
+    ptr += (attrTypeSize + sizeof(TID)) * pos;
     for(; pos < *cnt; pos++) {
-        DBAttrType * attr = DBAttrType::read(ptr, attrType, &ptr);
-        if (*attr > val) {
+        int cmp = compareKeys(ptr, key);
+        if (cmp > 0) {
             //val already skipped
             break;
-        } else if (*attr == val) {
+        }
+        ptr += attrTypeSize;
+        if (cmp == 0) {
             TID * tidPtr = (TID *) ptr;
             if(*tidPtr == tid.front()) {
                 LOG4CXX_DEBUG(logger, "Found at "+TO_STR(pos));
@@ -524,13 +1280,24 @@ bool DBMyIndex::removeFromLeafNode(const BlockNo b, const DBAttrType &val, const
                 --*cnt;
                 LOG4CXX_DEBUG(logger, "Keys after Delete: "+TO_STR(*cnt));
                 deleted = true;
+                stampLeaf(bacbStack.top().getDataPtr());
                 bacbStack.top().setModified();
+                //index is unique, ptr is no longer aligned after the shift
+                break;
             }
         }
         ptr += sizeof(TID);
     }
     if(!deleted)
         LOG4CXX_DEBUG(logger, "Error: Given value not found to delete");
+    if(leafFormat != LEAF_PLAIN) {
+        //ohne den Eintrag ist die Kodierung nie laenger, passt also wieder in die Seite
+        if(deleted && !encodeLeaf(&image[0], 0, *cnt, bacbStack.top().getDataPtr()))
+            throw DBIndexException("Compressed leaf does not fit after delete");
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        return false;
+    }
     bool mergeNeeded = *cnt < keysPerLeafNode()/2;
     if(mergeNeeded)
         LOG4CXX_DEBUG(logger, "TODO: Leaf Node is less than half full, merge possibly needed");
@@ -596,7 +1363,7 @@ bool DBMyIndex::rebalanceInnerNode(const BlockNo parentBlockNo, const BlockNo ch
             //move a key and TID from one leaf node to another
             DBAttrType * keyToMove;
             TID valueToMove;
-            DBAttrType * newParentKey;
+            DBAttrType * newParentKey = NULL;
             if(mergeFromLeft) {
                 --*child2Cnt;
                 child2Ptr += (attrTypeSize+sizeof(TID)) * (*child2Cnt);
@@ -613,6 +1380,7 @@ bool DBMyIndex::rebalanceInnerNode(const BlockNo parentBlockNo, const BlockNo ch
             }
             LOG4CXX_DEBUG(logger,"Key To Move: "+keyToMove->toString());
             LOG4CXX_DEBUG(logger,"Value To Move: "+valueToMove.toString());
+            stampLeaf(bacbStack.top().getDataPtr());
             bacbStack.top().setModified();
             bufMgr.unfixBlock(bacbStack.top());
             bacbStack.pop();
@@ -635,18 +1403,21 @@ bool DBMyIndex::rebalanceInnerNode(const BlockNo parentBlockNo, const BlockNo ch
                 char * to = (char *)childPtr+sizeof(TID)+attrTypeSize;
                 memmove(to, childPtr, (sizeof(TID)+attrTypeSize)*(*childCnt));
                 keyToMove->write((char *)childPtr);
-                TID * childTid = (TID *) childPtr + attrTypeSize;
+                TID * childTid = (TID *) (childPtr + attrTypeSize);
                 *childTid = valueToMove;
             } else {
                 childPtr += (*childCnt)*(sizeof(TID)+attrTypeSize);
                 keyToMove->write((char *)childPtr);
-                TID * childTid = (TID *) childPtr + attrTypeSize;
+                TID * childTid = (TID *) (childPtr + attrTypeSize);
                 *childTid = valueToMove;
             }
             ++*childCnt;
+            stampLeaf(bacbStack.top().getDataPtr());
             bacbStack.top().setModified();
             bufMgr.unfixBlock(bacbStack.top());
             bacbStack.pop();
+            delete keyToMove;
+            delete newParentKey;
         } else {
             //move a key and BlockNo from one inner node to another
             BlockNo blockNoToMove;
@@ -698,13 +1469,15 @@ bool DBMyIndex::rebalanceInnerNode(const BlockNo parentBlockNo, const BlockNo ch
             } else {
                 childPtr += sizeof(BlockNo) + (*childCnt)*(sizeof(BlockNo)+attrTypeSize);
                 keyToMove->write((char *)childPtr);
-                BlockNo * childBlockNo = (BlockNo *) childPtr + attrTypeSize;
+                BlockNo * childBlockNo = (BlockNo *) (childPtr + attrTypeSize);
                 *childBlockNo = blockNoToMove;
             }
             ++*childCnt;
             bacbStack.top().setModified();
             bufMgr.unfixBlock(bacbStack.top());
             bacbStack.pop();
+            delete keyToMove;
+            delete newParentKey;
         }
     } else {
         LOG4CXX_DEBUG(logger,"Merging Blocks "+TO_STR(child2BlockNo)+" and "+TO_STR(childBlockNo));
@@ -718,12 +1491,13 @@ bool DBMyIndex::rebalanceInnerNode(const BlockNo parentBlockNo, const BlockNo ch
             ptr -= attrTypeSize;
         }
         DBAttrType * keyToMove = DBAttrType::read(ptr, attrType);
-        if(pos+1 != *cnt) {
-            char * to = (char *) ptr;
-            ptr += attrTypeSize + sizeof(BlockNo);
-            memmove(to, ptr, (attrTypeSize + sizeof(BlockNo)) * (*cnt - pos - 1));
-            --*cnt;
-        }
+        //Schluessel und Zeiger des rechten Knotens entfernen, er ist Eintrag pos bzw. 1
+        uint removed = mergeFromLeft ? pos : 1;
+        char * to = (char *) ptr;
+        ptr += attrTypeSize + sizeof(BlockNo);
+        memmove(to, ptr, (attrTypeSize + sizeof(BlockNo)) * (*cnt - removed));
+        --*cnt;
+        bacbStack.top().setModified();
         if(childIsLeaf) {
             if(mergeFromLeft) {
                 mergeLeafNodes(child2BlockNo, childBlockNo);
@@ -737,13 +1511,15 @@ bool DBMyIndex::rebalanceInnerNode(const BlockNo parentBlockNo, const BlockNo ch
                 mergeInnerNodes(childBlockNo, child2BlockNo, *keyToMove);
             }
         }
+        delete keyToMove;
     }
     if(parentIsRoot) {
         if(*cnt == 0) {
             //merge needed
-            BlockNo newRoot = *((BlockNo *) bacbStack.top().getDataPtr() + sizeof(uint));
+            BlockNo newRoot = *(BlockNo *) (bacbStack.top().getDataPtr() + sizeof(uint));
             bufMgr.unfixBlock(bacbStack.top());
             bacbStack.pop();
+            releasePage(parentBlockNo);
 
             BlockNo * metaRootPtr = (BlockNo *) bacbStack.top().getDataPtr();
             *metaRootPtr = newRoot;
@@ -756,7 +1532,7 @@ bool DBMyIndex::rebalanceInnerNode(const BlockNo parentBlockNo, const BlockNo ch
         }
         return false;
     }
-    bool mergeNeeded = keysPerInnerNode()/2 < *cnt;
+    bool mergeNeeded = *cnt < keysPerInnerNode()/2;
 
     bufMgr.unfixBlock(bacbStack.top());
     bacbStack.pop();
@@ -793,6 +1569,7 @@ void DBMyIndex::mergeInnerNodes(const BlockNo leftNode, const BlockNo rightNode,
     bacbStack.top().setModified();
     bufMgr.unfixBlock(bacbStack.top());
     bacbStack.pop();
+    releasePage(rightNode);
 }
 
 void DBMyIndex::mergeLeafNodes(const BlockNo leftNode, const BlockNo rightNode) {
@@ -813,35 +1590,2687 @@ void DBMyIndex::mergeLeafNodes(const BlockNo leftNode, const BlockNo rightNode)
     memcpy(leftPtr, rightPtr, (attrTypeSize+sizeof(TID)) * (*rightCnt));
     *leftCnt += *rightCnt;
 
-    //right node is deleted
+    //right node is deleted, the stamp invalidates cursors positioned on it
+    stampLeaf(bacbStack.top().getDataPtr());
+    bacbStack.top().setModified();
     bufMgr.unfixBlock(bacbStack.top());
     bacbStack.pop();
 
     //left node is saved
+    stampLeaf(bacbStack.top().getDataPtr());
     bacbStack.top().setModified();
     bufMgr.unfixBlock(bacbStack.top());
     bacbStack.pop();
+    releasePage(rightNode);
 }
 
-void DBMyIndex::unfixBACBs(bool setDirty) {
-    LOG4CXX_INFO(logger,"unfixBACBs()");
-    LOG4CXX_DEBUG(logger,"setDirty: "+TO_STR(setDirty));
-    LOG4CXX_DEBUG(logger,"bacbStack.size()= "+TO_STR(bacbStack.size()));
-    while (bacbStack.empty() == false) {
-        try {
-            if (bacbStack.top().getModified()) {
-                if (setDirty == true)
-                    bacbStack.top().setDirty();
-            }
-            bufMgr.unfixBlock(bacbStack.top());
-        } catch (DBException & e) {
-        }
-        bacbStack.pop();
-    }
+/**
+ * Bereichsloeschung: statt jeden Schluessel einzeln zu suchen und zu entfernen
+ * - werden Kinder, deren Schluesselbereich (aus den Separatoren des Elternknotens)
+ *   ganz in [lo, hi] liegt, in einem Schritt aus dem Elternknoten entfernt und
+ *   ihre Seiten freigegeben, ohne die Blaetter zu lesen
+ * - werden nur die hoechstens zwei Randkinder je Ebene weiter bearbeitet, die
+ *   Randblaetter werden gekuerzt
+ * - wird danach einmal entlang der Pfade zu lo und hi ausgeglichen
+ * Liefert die Anzahl freigegebener Seiten. Im buffered und copy-on-write mode
+ * nicht moeglich, da Puffer bzw. alte Staende die ausgehaengten Seiten brauchen.
+ */
+uint DBMyIndex::removeRange(const DBAttrType &lo, const DBAttrType &hi) {
+    LOG4CXX_INFO(logger,"removeRange()");
+    LOG4CXX_DEBUG(logger,"lo: "+lo.toString()+", hi: "+hi.toString());
+    if (buffered)
+        throw DBIndexException("Range delete is not supported in buffered mode");
+    if (copyOnWrite)
+        throw DBIndexException("Range delete is not supported in copy-on-write mode");
+    if (isBuilding())
+        throw DBIndexException("Range delete is not supported during an online build");
+    writeScope scope(*this);
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (mappedPtr != NULL)
+        throw DBIndexException("Index is mapped read only");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+    loadSparePages();
+    arenaScope opScope(arena);
+
+    const char * loKey = keyBytes(lo);
+    const char * hiKey = keyBytes(hi);
+    if (compareKeys(loKey, hiKey) > 0)
+        return 0;
+    //geloeschte Schluessel bleiben im Bloom-Filter, bis er neu aufgebaut wird
+    countChange();
+
+    char * metaPtr = bacbStack.top().getDataPtr();
+    uint released = 0;
+    removeRangeInNode(*(BlockNo *) metaPtr, *((uint *) metaPtr+sizeof(BlockNo)), loKey, hiKey, NULL, NULL, released);
+
+    rebalancePath(lo, released);
+    rebalancePath(hi, released);
+    //das gemerkte rechteste Blatt kann ausgehaengt sein
+    appendLeaf = 0;
+
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    LOG4CXX_DEBUG(logger,"Pages released: "+TO_STR(released));
+    return released;
+}
+
+/**
+ * Entfernt [lo, hi] aus dem Teilbaum mit Wurzel b (Hoehe height, Blaetter 0),
+ * dessen Schluessel in [nodeLo, nodeHi) liegen (NULL: unbeschraenkt)
+ */
+void DBMyIndex::removeRangeInNode(BlockNo b, uint height, const char * lo, const char * hi, const char * nodeLo, const char * nodeHi, uint & released) {
+    LOG4CXX_INFO(logger,"removeRangeInNode()");
+    LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b)+", height: "+TO_STR(height));
+    if (height == 0) {
+        trimLeaf(b, lo, hi);
+        return;
+    }
+
+    const uint entrySize = attrTypeSize + sizeof(BlockNo);
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    char * pagePtr = bacbStack.top().getDataPtr();
+    uint * cnt = (uint *) pagePtr;
+    //Kind i steht bei entries + entrySize * i, sein linker Separator direkt davor
+    char * entries = pagePtr + sizeof(uint);
+
+    //Randkinder mit ihren Grenzen (kopiert, die Seite wird gleich geaendert)
+    vector<BlockNo> covered;
+    vector<BlockNo> boundary;
+    vector<const char *> bounds;
+    int first = -1, last = -1;
+    for (uint i = 0; i <= *cnt; i++) {
+        const char * lower = i == 0 ? nodeLo : entries + entrySize * i - attrTypeSize;
+        const char * upper = i == *cnt ? nodeHi : entries + entrySize * (i + 1) - attrTypeSize;
+        if (upper != NULL && compareKeys(upper, lo) <= 0)
+            continue;
+        if (lower != NULL && compareKeys(lower, hi) > 0)
+            break;
+        BlockNo child = *(BlockNo *) (entries + entrySize * i);
+        if (lower != NULL && upper != NULL && compareKeys(lo, lower) <= 0 && compareKeys(upper, hi) <= 0) {
+            if (first < 0)
+                first = i;
+            last = i;
+            covered.push_back(child);
+        } else {
+            boundary.push_back(child);
+            for (uint j = 0; j < 2; j++) {
+                const char * bound = j == 0 ? lower : upper;
+                char * copy = NULL;
+                if (bound != NULL) {
+                    copy = arena.alloc(attrTypeSize);
+                    memcpy(copy, bound, attrTypeSize);
+                }
+                bounds.push_back(copy);
+            }
+        }
+    }
+
+    if (covered.empty() == false) {
+        LOG4CXX_DEBUG(logger,"Detaching children "+TO_STR(first)+" to "+TO_STR(last));
+        //ein ganz ueberdeckter Knoten waere schon im Elternknoten ausgehaengt worden
+        assert(first > 0 || last < (int) *cnt);
+        if (first > 0) {
+            //Separatoren und Zeiger first..last entfernen
+            char * to = entries + entrySize * first - attrTypeSize;
+            memmove(to, to + entrySize * (last - first + 1), entrySize * (*cnt - last));
+        } else {
+            //Kind last+1 wird erstes Kind, sein linker Separator faellt weg
+            memmove(entries, entries + entrySize * (last + 1), sizeof(BlockNo) + entrySize * (*cnt - last - 1));
+        }
+        *cnt -= first > 0 ? last - first + 1 : last + 1;
+        bacbStack.top().setModified();
+    }
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+
+    for (size_t i = 0; i < covered.size(); i++)
+        releaseSubtree(covered[i], height - 1, released);
+    for (size_t i = 0; i < boundary.size(); i++)
+        removeRangeInNode(boundary[i], height - 1, lo, hi, bounds[2 * i], bounds[2 * i + 1], released);
+}
+
+//entfernt die Eintraege mit Schluessel in [lo, hi] aus einem Randblatt
+void DBMyIndex::trimLeaf(BlockNo b, const char * lo, const char * hi) {
+    LOG4CXX_INFO(logger,"trimLeaf()");
+    LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b));
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    char * ptr = bacbStack.top().getDataPtr();
+    if (leafFormat != LEAF_PLAIN) {
+        decodeLeaf(ptr, leafImage);
+        ptr = &leafImage[0];
+    }
+    uint * cnt = (uint *) ptr;
+    char * entries = ptr + sizeof(uint);
+    uint from = leafSearch(entries, *cnt, lo, attrTypeSize);
+    uint to = from;
+    while (to < *cnt && compareKeys(entries + entrySize * to, hi) <= 0)
+        to++;
+    if (to > from) {
+        LOG4CXX_DEBUG(logger,"Removing entries "+TO_STR(from)+" to "+TO_STR(to - 1));
+        memmove(entries + entrySize * from, entries + entrySize * to, entrySize * (*cnt - to));
+        *cnt -= to - from;
+        //ohne die Eintraege ist die Kodierung nie laenger, passt also wieder in die Seite
+        if (leafFormat != LEAF_PLAIN && !encodeLeaf(&leafImage[0], 0, *cnt, bacbStack.top().getDataPtr()))
+            throw DBIndexException("Compressed leaf does not fit after delete");
+        stampLeaf(bacbStack.top().getDataPtr());
+        bacbStack.top().setModified();
+    }
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+}
+
+//gibt alle Seiten eines ausgehaengten Teilbaums frei, nur innere Knoten werden dabei gelesen
+void DBMyIndex::releaseSubtree(BlockNo b, uint height, uint & released) {
+    if (height > 0) {
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+        const char * ptr = bacbStack.top().getDataPtr();
+        uint cnt = *(const uint *) ptr;
+        vector<BlockNo> children(cnt + 1);
+        for (uint i = 0; i <= cnt; i++)
+            children[i] = *(const BlockNo *) (ptr + sizeof(uint) + (attrTypeSize + sizeof(BlockNo)) * i);
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        for (uint i = 0; i <= cnt; i++)
+            releaseSubtree(children[i], height - 1, released);
+    }
+    releasePage(b);
+    released++;
+}
+
+/**
+ * Gleicht die Knoten auf dem Pfad zu val nach einer Bereichsloeschung aus. Ein
+ * Knoten kann dabei mehr als einen Eintrag verloren haben, ein innerer Knoten
+ * auch alle Separatoren. Daher von oben nach unten: erst die Wurzel ohne
+ * Separatoren durch ihr Kind ersetzen, dann den ersten unterbesetzten Knoten
+ * mit seinem Geschwister ausgleichen und neu absteigen, bis keiner mehr
+ * unterbesetzt ist. Der Abstieg laeuft so nie durch einen leeren inneren Knoten.
+ */
+void DBMyIndex::rebalancePath(const DBAttrType &val, uint & released) {
+    LOG4CXX_INFO(logger,"rebalancePath()");
+    char * metaPtr = bacbStack.top().getDataPtr();
+    uint * depth = (uint *) metaPtr + sizeof(BlockNo);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        while (*depth > 0) {
+            BlockNo root = *(BlockNo *) metaPtr;
+            bacbStack.push(bufMgr.fixBlock(file, root, LOCK_SHARED));
+            uint cnt = *(uint *) bacbStack.top().getDataPtr();
+            BlockNo child = *(BlockNo *) (bacbStack.top().getDataPtr() + sizeof(uint));
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+            if (cnt != 0)
+                break;
+            LOG4CXX_DEBUG(logger,"New root "+TO_STR(child));
+            *(BlockNo *) metaPtr = child;
+            --*depth;
+            bacbStack.top().setModified();
+            releasePage(root);
+            released++;
+        }
+
+        BlockNo parent = *(BlockNo *) metaPtr;
+        for (uint level = 1; level <= *depth; level++) {
+            BlockNo child = findInInnerNode(val, parent);
+            bool childIsLeaf = level == *depth;
+            //komprimierte Blaetter werden nicht zusammengelegt
+            if (childIsLeaf == false || leafFormat == LEAF_PLAIN) {
+                bacbStack.push(bufMgr.fixBlock(file, child, LOCK_SHARED));
+                uint childCnt = *(uint *) bacbStack.top().getDataPtr();
+                bufMgr.unfixBlock(bacbStack.top());
+                bacbStack.pop();
+                if (childCnt < (childIsLeaf ? keysPerLeafNode()/2 : keysPerInnerNode()/2)) {
+                    rebalanceInnerNode(parent, child, childIsLeaf, level == 1);
+                    changed = true;
+                    break;
+                }
+            }
+            parent = child;
+        }
+    }
+}
+
+/**
+ * Neue Nachricht zu val: landet im Puffer der Wurzel; ist dieser voll, wird
+ * zuerst eine Charge eine Ebene tiefer geschoben. Ohne innere Knoten wird sie
+ * direkt auf das Blatt angewendet.
+ */
+void DBMyIndex::deliverMessage(const DBAttrType &val, char op, const TID &tid) {
+    LOG4CXX_INFO(logger,"deliverMessage()");
+    LOG4CXX_DEBUG(logger,"val: "+val.toString()+", op: "+TO_STR((int) op));
+    const uint msgSize = attrTypeSize + sizeof(TID) + sizeof(char);
+    char * msg = arena.alloc(msgSize);
+    memcpy(msg, keyBytes(val), attrTypeSize);
+    memcpy(msg + attrTypeSize, &tid, sizeof(TID));
+    msg[attrTypeSize + sizeof(TID)] = op;
+
+    while (true) {
+        //ein Leeren kann die Wurzel teilen, daher jede Runde neu lesen
+        char * metaPtr = bacbStack.top().getDataPtr();
+        BlockNo root = *(BlockNo *) metaPtr;
+        uint depth = *((uint *) metaPtr+sizeof(BlockNo));
+        if (depth == 0) {
+            applyToLeaf(root, msg, 1);
+            return;
+        }
+        if (mergeIntoBuffer(root, msg, 1) == 1)
+            return;
+        flushBuffer(root, depth);
+    }
+}
+
+/**
+ * Uebernimmt n Nachrichten in einem Durchgang in den Puffer des inneren Knotens b.
+ * Eine vorhandene Nachricht zum selben Schluessel ist aelter und wird ersetzt.
+ * Liefert die Anzahl uebernommener Nachrichten, weniger als n bei vollem Puffer.
+ */
+uint DBMyIndex::mergeIntoBuffer(const BlockNo b, const char * msgs, uint n) {
+    LOG4CXX_INFO(logger,"mergeIntoBuffer()");
+    LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b)+", messages: "+TO_STR(n));
+    const uint msgSize = attrTypeSize + sizeof(TID) + sizeof(char);
+
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    char * ptr = bacbStack.top().getDataPtr() + innerBufferOffset();
+    uint * msgCnt = (uint *) ptr;
+    ptr += sizeof(uint);
+
+    uint i = 0;
+    for (; i < n; i++) {
+        const char * msg = msgs + msgSize * i;
+        uint pos = 0;
+        while (pos < *msgCnt && compareKeys(ptr + msgSize * pos, msg) != 0)
+            pos++;
+        if (pos == *msgCnt) {
+            if (*msgCnt == msgsPerBuffer()) {
+                LOG4CXX_DEBUG(logger,"Buffer full");
+                break;
+            }
+            ++*msgCnt;
+        }
+        memcpy(ptr + msgSize * pos, msg, msgSize);
+    }
+    LOG4CXX_DEBUG(logger,"Messages in buffer: "+TO_STR(*msgCnt));
+
+    if (i > 0)
+        bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    return i;
+}
+
+/**
+ * Leert den Teil des Puffers von b, der zum Kind mit den meisten Nachrichten
+ * gehoert, und wendet diese Charge nach Schluessel sortiert auf das Kind an.
+ */
+void DBMyIndex::flushBuffer(const BlockNo b, uint height) {
+    LOG4CXX_INFO(logger,"flushBuffer()");
+    LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b)+", height: "+TO_STR(height));
+    const uint msgSize = attrTypeSize + sizeof(TID) + sizeof(char);
+
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    char * pagePtr = bacbStack.top().getDataPtr();
+    uint cnt = *(uint *) pagePtr;
+    uint * msgCnt = (uint *) (pagePtr + innerBufferOffset());
+    char * msgs = (char *) (msgCnt + 1);
+
+    //Kindposition jeder Nachricht bestimmen (Gleichheit mit Schluessel geht nach rechts)
+    vector<uint> childOf(*msgCnt);
+    vector<uint> msgsPerChild(cnt + 1, 0);
+    for (uint i = 0; i < *msgCnt; i++) {
+        childOf[i] = innerSearch(pagePtr + sizeof(uint) + sizeof(BlockNo), cnt, msgs + msgSize * i, attrTypeSize);
+        msgsPerChild[childOf[i]]++;
+    }
+    uint target = 0;
+    for (uint i = 1; i <= cnt; i++) {
+        if (msgsPerChild[i] > msgsPerChild[target])
+            target = i;
+    }
+    BlockNo child = *(BlockNo *) (pagePtr + sizeof(uint) + (sizeof(BlockNo) + attrTypeSize) * target);
+    LOG4CXX_DEBUG(logger,"Flushing "+TO_STR(msgsPerChild[target])+" messages to child "+TO_STR(child));
+
+    //Charge sortiert herausnehmen, restliche Nachrichten zusammenschieben
+    vector<char> batch;
+    batch.reserve(msgSize * msgsPerChild[target]);
+    uint kept = 0;
+    for (uint i = 0; i < *msgCnt; i++) {
+        char * msgPtr = msgs + msgSize * i;
+        if (childOf[i] == target) {
+            uint lo = 0, hi = batch.size() / msgSize;
+            while (lo < hi) {
+                uint mid = (lo + hi) / 2;
+                if (compareKeys(&batch[msgSize * mid], msgPtr) < 0)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            batch.insert(batch.begin() + msgSize * lo, msgPtr, msgPtr + msgSize);
+        } else {
+            if (kept != i)
+                memmove(msgs + msgSize * kept, msgPtr, msgSize);
+            kept++;
+        }
+    }
+    *msgCnt = kept;
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+
+    applyBatch(batch, height - 1, child);
+}
+
+/**
+ * Wendet eine nach Schluessel sortierte Charge auf die Knoten der Hoehe height
+ * an, je Zielknoten in einem Durchgang. node ist der Zielknoten der ganzen
+ * Charge. Musste unterwegs ein Puffer geleert werden, kann sich der Baum
+ * darunter geaendert haben; der Rest wird dann mit einem Abstieg je Zielknoten
+ * neu zugeordnet.
+ */
+void DBMyIndex::applyBatch(const vector<char> & batch, uint height, BlockNo node) {
+    LOG4CXX_INFO(logger,"applyBatch()");
+    const uint msgSize = attrTypeSize + sizeof(TID) + sizeof(char);
+    uint total = batch.size() / msgSize;
+    uint done = 0;
+    vector<char> upper;
+    while (done < total) {
+        uint n = total - done;
+        if (node == 0) {
+            node = descendTo(&batch[msgSize * done], height, upper);
+            if (upper.empty() == false) {
+                n = 1;
+                while (done + n < total && compareKeys(&batch[msgSize * (done + n)], &upper[0]) < 0)
+                    n++;
+            }
+        }
+        if (height == 0) {
+            applyToLeaf(node, &batch[msgSize * done], n);
+            done += n;
+        } else {
+            uint merged = mergeIntoBuffer(node, &batch[msgSize * done], n);
+            done += merged;
+            if (merged < n)
+                flushBuffer(node, height);
+        }
+        node = 0;
+    }
+}
+
+/**
+ * Abstieg ab der Wurzel zum Knoten der Hoehe height, in dessen Teilbaum key liegt.
+ * upper erhaelt die (exklusive) obere Grenze dieses Teilbaums, leer = keine.
+ * path nimmt, falls angegeben, alle besuchten Knoten auf.
+ */
+BlockNo DBMyIndex::descendTo(const char * key, uint height, vector<char> & upper, pathStack * path) {
+    char * metaPtr = bacbStack.top().getDataPtr();
+    BlockNo b = *(BlockNo *) metaPtr;
+    uint depth = *((uint *) metaPtr+sizeof(BlockNo));
+    upper.clear();
+    if (path != NULL)
+        path->push(b);
+    for (uint h = depth; h > height; h--) {
+        const char * ptr = fixPageForRead(b) + sizeof(uint);
+        uint cnt = *((const uint *) ptr - 1);
+        uint child = innerSearch(ptr + sizeof(BlockNo), cnt, key, attrTypeSize);
+        ptr += (sizeof(BlockNo) + attrTypeSize) * child;
+        if (child < cnt)
+            upper.assign(ptr + sizeof(BlockNo), ptr + sizeof(BlockNo) + attrTypeSize);
+        b = *(const BlockNo *) ptr;
+        unfixPageForRead();
+        if (path != NULL)
+            path->push(b);
+    }
+    return b;
+}
+
+/**
+ * Traegt den Trennschluessel key der neuen Seite newBlockNo in den Knoten der
+ * Hoehe height ein (ein Abstieg je Split, nicht je Nachricht)
+ */
+void DBMyIndex::insertSeparator(const char * key, const BlockNo newBlockNo, uint height) {
+    LOG4CXX_INFO(logger,"insertSeparator()");
+    pathStack blocks;
+    vector<char> upper;
+    //Blatt als Wurzel: der Split erzeugt eine neue Wurzel
+    if (*((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)) >= height)
+        descendTo(key, height, upper, &blocks);
+    splitInfo splitResult;
+    splitResult.splitHappens = true;
+    splitResult.newKey = key;
+    splitResult.newBlockNo = newBlockNo;
+    propagateSplit(blocks, splitResult);
+}
+
+/**
+ * Verteilt beim Split eines inneren Knotens den Puffer: Nachrichten mit
+ * Schluessel >= separator wandern in den neuen rechten Knoten
+ */
+void DBMyIndex::splitBuffer(char * leftPtr, char * rightPtr, const char * separator) {
+    LOG4CXX_INFO(logger,"splitBuffer()");
+    const uint msgSize = attrTypeSize + sizeof(TID) + sizeof(char);
+
+    uint * leftCnt = (uint *) (leftPtr + innerBufferOffset());
+    uint * rightCnt = (uint *) (rightPtr + innerBufferOffset());
+    char * leftMsgs = (char *) (leftCnt + 1);
+    char * rightMsgs = (char *) (rightCnt + 1);
+    uint kept = 0;
+    *rightCnt = 0;
+    for (uint i = 0; i < *leftCnt; i++) {
+        char * msgPtr = leftMsgs + msgSize * i;
+        if (compareKeys(msgPtr, separator) >= 0) {
+            memcpy(rightMsgs + msgSize * (*rightCnt), msgPtr, msgSize);
+            ++*rightCnt;
+        } else {
+            if (kept != i)
+                memmove(leftMsgs + msgSize * kept, msgPtr, msgSize);
+            kept++;
+        }
+    }
+    *leftCnt = kept;
+    LOG4CXX_DEBUG(logger,"Messages left: "+TO_STR(*leftCnt)+", right: "+TO_STR(*rightCnt));
+}
+
+/**
+ * Wendet n nach Schluessel sortierte Nachrichten in einem Durchgang auf das
+ * Blatt b an: ein Insert ersetzt einen vorhandenen Eintrag, ein Delete entfernt
+ * ihn. Laeuft das Blatt ueber, wird es auf so viele Seiten verteilt wie noetig,
+ * deren Trennschluessel danach in die Elternknoten kommen.
+ * Im buffered mode werden Blaetter beim Loeschen nicht zusammengelegt.
+ */
+void DBMyIndex::applyToLeaf(const BlockNo b, const char * msgs, uint n) {
+    LOG4CXX_INFO(logger,"applyToLeaf()");
+    LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b)+", messages: "+TO_STR(n));
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const uint msgSize = entrySize + sizeof(char);
+
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    char * page = bacbStack.top().getDataPtr();
+    const char * entries = page;
+    if (leafFormat != LEAF_PLAIN) {
+        decodeLeaf(page, leafImage);
+        entries = &leafImage[0];
+    }
+    uint cnt = *(const uint *) entries;
+    entries += sizeof(uint);
+
+    //Blatt und Nachrichten mischen
+    vector<char> image(sizeof(uint) + entrySize * (cnt + n));
+    char * out = &image[sizeof(uint)];
+    uint e = 0, m = 0;
+    while (m < n) {
+        const char * msg = msgs + msgSize * m;
+        int cmp = e < cnt ? compareKeys(entries + entrySize * e, msg) : 1;
+        if (cmp < 0) {
+            memcpy(out, entries + entrySize * e++, entrySize);
+            out += entrySize;
+            continue;
+        }
+        //vorhandener Eintrag ist aelter als die Nachricht
+        if (cmp == 0)
+            e++;
+        if (msg[entrySize] == MSG_INSERT) {
+            memcpy(out, msg, entrySize);
+            out += entrySize;
+        }
+        m++;
+    }
+    memcpy(out, entries + entrySize * e, entrySize * (cnt - e));
+    out += entrySize * (cnt - e);
+    uint total = (out - &image[sizeof(uint)]) / entrySize;
+    *(uint *) &image[0] = total;
+
+    //Aufteilung in Seiten: [bounds[i], bounds[i+1])
+    vector<uint> bounds(1, 0);
+    if (leafFormat == LEAF_PLAIN) {
+        uint pages = max((total + keysPerLeafNode() - 1) / keysPerLeafNode(), 1u);
+        for (uint i = 1; i <= pages; i++)
+            bounds.push_back((uint) ((size_t) total * i / pages));
+    } else {
+        //kodierte Groesse ist nur durch Probieren bekannt, zu grosse Bereiche halbieren
+        leafScratch.resize(DBFileBlock::getBlockSize());
+        vector<uint> pending(1, total);
+        while (pending.empty() == false) {
+            uint from = bounds.back(), to = pending.back();
+            if (to - from <= 1 || encodeLeaf(&image[0], from, to, &leafScratch[0])) {
+                bounds.push_back(to);
+                pending.pop_back();
+            } else {
+                pending.push_back(from + (to - from) / 2);
+            }
+        }
+    }
+    LOG4CXX_DEBUG(logger,"Entries after apply: "+TO_STR(total)+", pages: "+TO_STR(bounds.size() - 1));
+
+    vector<char> separators;
+    vector<BlockNo> newPages;
+    BlockNo prev = b;
+    for (uint i = 0; i + 1 < bounds.size(); i++) {
+        if (i > 0) {
+            bacbStack.push(fixNewPage(prev));
+            page = bacbStack.top().getDataPtr();
+            prev = bacbStack.top().getBlockNo();
+            newPages.push_back(prev);
+            const char * first = &image[sizeof(uint)] + entrySize * bounds[i];
+            separators.insert(separators.end(), first, first + attrTypeSize);
+        }
+        if (leafFormat == LEAF_PLAIN) {
+            *(uint *) page = bounds[i + 1] - bounds[i];
+            memcpy(page + sizeof(uint), &image[sizeof(uint)] + entrySize * bounds[i], entrySize * (bounds[i + 1] - bounds[i]));
+        } else if (encodeLeaf(&image[0], bounds[i], bounds[i + 1], page) == false) {
+            //ein einzelner Eintrag passt immer (attrTypeSize < 256, siehe Konstruktor)
+            throw DBIndexException("Compressed leaf apply failed");
+        }
+        stampLeaf(page);
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+    }
+
+    for (uint i = 0; i < newPages.size(); i++) {
+        LOG4CXX_DEBUG(logger,"Leaf Node "+TO_STR(b)+" was split, new Block "+TO_STR(newPages[i])+" was created");
+        char * key = arena.alloc(attrTypeSize);
+        memcpy(key, &separators[attrTypeSize * i], attrTypeSize);
+        insertSeparator(key, newPages[i], 1);
+    }
+}
+
+/**
+ * Praefixkodierte Blaetter (LEAF_FRONTCODED, bei LEAF_PACKED als Ausweichformat):
+ * - Seite: | uint cnt | uint usedBytes | Eintrag * cnt |
+ * - Eintrag: | uchar shared | uchar suffixLen | suffix | varint TID.page (Delta) | varint TID.slot |
+ * Schluessel sind gegen den Vorgaenger praefixkodiert, Nullbytes am Ende werden
+ * nicht gespeichert. Ein Blatt nimmt so viele Eintraege auf, wie kodiert in die
+ * Seite passen, keysPerLeafNode() gilt hier nicht.
+ * Zum Bearbeiten wird ein Blatt in ein Abbild im unkomprimierten Format
+ * (| uint cnt | (key, TID) * cnt |) dekodiert.
+ */
+
+//INT und DOUBLE in Big Endian, damit benachbarte Schluessel gemeinsame Praefixe haben
+void DBMyIndex::codecKey(char * key) const {
+    if (attrType == INT || attrType == DOUBLE) {
+        for (uint i = 0; i < attrTypeSize / 2; i++)
+            swap(key[i], key[attrTypeSize - 1 - i]);
+    }
+}
+
+static char * writeVarint(char * ptr, uint v) {
+    while (v >= 0x80) {
+        *ptr++ = (char) (v | 0x80);
+        v >>= 7;
+    }
+    *ptr++ = (char) v;
+    return ptr;
+}
+
+static const char * readVarint(const char * ptr, uint & v) {
+    v = 0;
+    for (uint shift = 0; ; shift += 7) {
+        unsigned char c = (unsigned char) *ptr++;
+        v |= (uint) (c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+            return ptr;
+    }
+}
+
+/**
+ * Kodiert einen Eintrag (key bereits durch codecKey umgestellt) nach out und
+ * liefert die Laenge; ohne Vorgaenger (prevKey == NULL) wird nichts geteilt
+ */
+uint DBMyIndex::encodeLeafEntry(char * out, const char * prevKey, const char * key, const TID * prevTid, const TID & tid) const {
+    uint shared = 0;
+    if (prevKey != NULL) {
+        while (shared < attrTypeSize && prevKey[shared] == key[shared])
+            shared++;
+    }
+    uint len = attrTypeSize;
+    while (len > shared && key[len - 1] == 0)
+        len--;
+    char * ptr = out;
+    *ptr++ = (char) shared;
+    *ptr++ = (char) (len - shared);
+    memcpy(ptr, key + shared, len - shared);
+    ptr += len - shared;
+    int delta = (int) (tid.page - (prevTid != NULL ? prevTid->page : 0));
+    ptr = writeVarint(ptr, ((uint) delta << 1) ^ (uint) (delta >> 31));
+    ptr = writeVarint(ptr, tid.slot);
+    return ptr - out;
+}
+
+/**
+ * Dekodiert die Blattseite page in image; reserve haelt Platz fuer weitere Eintraege frei
+ */
+void DBMyIndex::decodeLeaf(const char * page, vector<char> & image, uint reserve) const {
+    if (*((const uint *) page + 1) & packedLeafMark) {
+        decodePackedLeaf(page, image, reserve);
+        return;
+    }
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    uint cnt = *(const uint *) page;
+    image.assign(sizeof(uint) + entrySize * (cnt + reserve), 0);
+    *(uint *) &image[0] = cnt;
+
+    const char * ptr = page + 2 * sizeof(uint);
+    char * out = &image[sizeof(uint)];
+    //komprimierte Formate setzen attrTypeSize < 256 voraus
+    char prevKey[256];
+    memset(prevKey, 0, attrTypeSize);
+    TID prevTid;
+    for (uint i = 0; i < cnt; i++) {
+        ptr = decodeLeafEntry(ptr, prevKey, prevTid);
+        memcpy(out, &prevKey[0], attrTypeSize);
+        codecKey(out);
+        out += attrTypeSize;
+        memcpy(out, &prevTid, sizeof(TID));
+        out += sizeof(TID);
+    }
+}
+
+/**
+ * Dekodiert den Eintrag bei ptr ueber seinen Vorgaenger: prevKey (noch im
+ * Format von codecKey) und prevTid werden ersetzt, liefert den naechsten Eintrag
+ */
+const char * DBMyIndex::decodeLeafEntry(const char * ptr, char * prevKey, TID & prevTid) const {
+    uint shared = (unsigned char) *ptr++;
+    uint suffixLen = (unsigned char) *ptr++;
+    memcpy(&prevKey[shared], ptr, suffixLen);
+    memset(&prevKey[shared + suffixLen], 0, attrTypeSize - shared - suffixLen);
+    ptr += suffixLen;
+
+    uint zigzag, slot;
+    ptr = readVarint(ptr, zigzag);
+    ptr = readVarint(ptr, slot);
+    prevTid.page = prevTid.page + (BlockNo) ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+    prevTid.slot = slot;
+    return ptr;
+}
+
+/**
+ * Sucht key in einem praefixkodierten Blatt, ohne es in ein Abbild zu
+ * dekodieren; die Eintraege werden nur bis zum ersten groesseren Schluessel gelesen
+ */
+bool DBMyIndex::findInFrontCodedLeaf(const char * page, const char * key, TID & tid) const {
+    uint cnt = *(const uint *) page;
+    const char * ptr = page + 2 * sizeof(uint);
+    char prevKey[256];
+    char entryKey[256];
+    memset(prevKey, 0, attrTypeSize);
+    TID prevTid;
+    for (uint i = 0; i < cnt; i++) {
+        ptr = decodeLeafEntry(ptr, prevKey, prevTid);
+        memcpy(entryKey, prevKey, attrTypeSize);
+        codecKey(entryKey);
+        int cmp = compareKeys(entryKey, key);
+        if (cmp == 0) {
+            tid = prevTid;
+            return true;
+        }
+        if (cmp > 0)
+            break;
+    }
+    return false;
+}
+
+/**
+ * Kodiert die Eintraege [from, to) des Abbilds in die Blattseite page.
+ * Rueckgabe false, wenn sie nicht in die Seite passen; page ist dann teilweise
+ * ueberschrieben und muss neu kodiert werden.
+ */
+bool DBMyIndex::encodeLeaf(const char * image, uint from, uint to, char * page) const {
+    //gepacktes Format bevorzugt, praefixkodiert nur, wenn Ausreisser die Bitbreiten sprengen
+    if (leafFormat == LEAF_PACKED && encodePackedLeaf(image, from, to, page))
+        return true;
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const char * end = page + leafVersionOffset();
+    char * ptr = page + 2 * sizeof(uint);
+    //Eintrag: 2 Laengenbytes, Schluessel, zwei Varints
+    char out[2 + 256 + 10];
+    char keys[2][256];
+    char * key = keys[0];
+    char * prevKey = keys[1];
+    TID prevTid;
+    for (uint i = from; i < to; i++) {
+        const char * entry = image + sizeof(uint) + entrySize * i;
+        memcpy(key, entry, attrTypeSize);
+        codecKey(key);
+        TID tid;
+        memcpy(&tid, entry + attrTypeSize, sizeof(TID));
+        uint len = encodeLeafEntry(out, i == from ? NULL : prevKey, key, i == from ? NULL : &prevTid, tid);
+        if (ptr + len > end)
+            return false;
+        memcpy(ptr, out, len);
+        ptr += len;
+        swap(key, prevKey);
+        prevTid = tid;
+    }
+    *(uint *) page = to - from;
+    *((uint *) page + 1) = ptr - page - 2 * sizeof(uint);
+    return true;
+}
+
+/**
+ * Splitposition fuer ein uebergelaufenes Abbild: erster Eintrag, ab dem die
+ * kodierte Groesse die Haelfte erreicht
+ */
+uint DBMyIndex::leafSplitPos(const char * image) const {
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    uint cnt = *(const uint *) image;
+    vector<uint> sizes(cnt);
+    vector<char> buf(entrySize + 12), key(attrTypeSize), prevKey(attrTypeSize);
+    TID prevTid;
+    uint total = 0;
+    for (uint i = 0; i < cnt; i++) {
+        const char * entry = image + sizeof(uint) + entrySize * i;
+        memcpy(&key[0], entry, attrTypeSize);
+        codecKey(&key[0]);
+        TID tid;
+        memcpy(&tid, entry + attrTypeSize, sizeof(TID));
+        sizes[i] = encodeLeafEntry(&buf[0], i == 0 ? NULL : &prevKey[0], &key[0], i == 0 ? NULL : &prevTid, tid);
+        total += sizes[i];
+        key.swap(prevKey);
+        prevTid = tid;
+    }
+    uint pos = 0, left = 0;
+    while (pos < cnt - 1 && left + sizes[pos] <= total / 2)
+        left += sizes[pos++];
+    return max(pos, 1u);
+}
+
+/**
+ * Gepackte Blaetter (LEAF_PACKED, nur INT):
+ * - Seite: | uint cnt | uint packedLeafMark + usedBytes | uchar keyBits | uchar pageBits | uchar slotBits | uchar |
+ *          int keyBase | BlockNo pageBase | uint slotBase | Bits |
+ * - Bits: spaltenweise erst alle Schluessel, dann alle TID.page, dann alle TID.slot,
+ *   jeweils als Abstand zum Minimum der Seite mit fester Bitbreite
+ * Die Schluessel bleiben sortiert, die Suche arbeitet direkt auf den gepackten Bits.
+ */
+static const uint packedHeaderSize = 2 * sizeof(uint) + 4 + sizeof(int) + sizeof(BlockNo) + sizeof(uint);
+
+static uint bitsFor(uint range) {
+    uint bits = 0;
+    while (bits < 32 && (range >> bits) != 0)
+        bits++;
+    return bits;
+}
+
+static void putBits(unsigned char * data, size_t bitPos, uint bits, uint value) {
+    for (uint i = 0; i < bits;) {
+        uint off = bitPos & 7;
+        uint n = min(8 - off, bits - i);
+        data[bitPos >> 3] |= (unsigned char) (((value >> i) & ((1u << n) - 1)) << off);
+        i += n;
+        bitPos += n;
+    }
+}
+
+static uint getBits(const unsigned char * data, size_t bitPos, uint bits) {
+    uint value = 0;
+    for (uint i = 0; i < bits;) {
+        uint off = bitPos & 7;
+        uint n = min(8 - off, bits - i);
+        value |= ((uint) (data[bitPos >> 3] >> off) & ((1u << n) - 1)) << i;
+        i += n;
+        bitPos += n;
+    }
+    return value;
+}
+
+bool DBMyIndex::encodePackedLeaf(const char * image, uint from, uint to, char * page) const {
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const uint cnt = to - from;
+    //Eintraege werden direkt aus dem Abbild gelesen
+    const char * entries = image + sizeof(uint) + entrySize * from;
+    int keyBase = 0, keyMax = 0;
+    BlockNo pageBase = 0, pageMax = 0;
+    uint slotBase = 0, slotMax = 0;
+    for (uint i = 0; i < cnt; i++) {
+        TID tid;
+        memcpy(&tid, entries + entrySize * i + attrTypeSize, sizeof(TID));
+        if (i == 0) {
+            memcpy(&keyBase, entries, sizeof(int));
+            pageBase = pageMax = tid.page;
+            slotBase = slotMax = tid.slot;
+        }
+        pageBase = min(pageBase, tid.page);
+        pageMax = max(pageMax, tid.page);
+        slotBase = min(slotBase, tid.slot);
+        slotMax = max(slotMax, tid.slot);
+    }
+    //Schluessel sind sortiert, der letzte ist der groesste
+    if (cnt > 0)
+        memcpy(&keyMax, entries + entrySize * (cnt - 1), sizeof(int));
+    uint keyBits = bitsFor((uint) keyMax - (uint) keyBase);
+    uint pageBits = bitsFor(pageMax - pageBase);
+    uint slotBits = bitsFor(slotMax - slotBase);
+    size_t used = ((size_t) cnt * (keyBits + pageBits + slotBits) + 7) / 8;
+    if (packedHeaderSize + used > leafVersionOffset())
+        return false;
+
+    memset(page, 0, packedHeaderSize + used);
+    uint * header = (uint *) page;
+    header[0] = cnt;
+    header[1] = packedLeafMark | (uint) used;
+    unsigned char * bits = (unsigned char *) (header + 2);
+    bits[0] = keyBits;
+    bits[1] = pageBits;
+    bits[2] = slotBits;
+    char * ptr = (char *) (bits + 4);
+    memcpy(ptr, &keyBase, sizeof(int));
+    ptr += sizeof(int);
+    memcpy(ptr, &pageBase, sizeof(BlockNo));
+    ptr += sizeof(BlockNo);
+    memcpy(ptr, &slotBase, sizeof(uint));
+    ptr += sizeof(uint);
+
+    unsigned char * data = (unsigned char *) ptr;
+    size_t bitPos = 0;
+    for (uint i = 0; i < cnt; i++, bitPos += keyBits) {
+        int key;
+        memcpy(&key, entries + entrySize * i, sizeof(int));
+        putBits(data, bitPos, keyBits, (uint) key - (uint) keyBase);
+    }
+    for (uint i = 0; i < cnt; i++, bitPos += pageBits) {
+        TID tid;
+        memcpy(&tid, entries + entrySize * i + attrTypeSize, sizeof(TID));
+        putBits(data, bitPos, pageBits, tid.page - pageBase);
+    }
+    for (uint i = 0; i < cnt; i++, bitPos += slotBits) {
+        TID tid;
+        memcpy(&tid, entries + entrySize * i + attrTypeSize, sizeof(TID));
+        putBits(data, bitPos, slotBits, tid.slot - slotBase);
+    }
+    return true;
+}
+
+void DBMyIndex::decodePackedLeaf(const char * page, vector<char> & image, uint reserve) const {
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const uint * header = (const uint *) page;
+    uint cnt = header[0];
+    const unsigned char * bits = (const unsigned char *) (header + 2);
+    uint keyBits = bits[0], pageBits = bits[1], slotBits = bits[2];
+    const char * ptr = (const char *) (bits + 4);
+    int keyBase;
+    BlockNo pageBase;
+    uint slotBase;
+    memcpy(&keyBase, ptr, sizeof(int));
+    memcpy(&pageBase, ptr + sizeof(int), sizeof(BlockNo));
+    memcpy(&slotBase, ptr + sizeof(int) + sizeof(BlockNo), sizeof(uint));
+    const unsigned char * data = (const unsigned char *) (ptr + sizeof(int) + sizeof(BlockNo) + sizeof(uint));
+
+    image.assign(sizeof(uint) + entrySize * (cnt + reserve), 0);
+    *(uint *) &image[0] = cnt;
+    char * out = &image[sizeof(uint)];
+    const size_t pageCol = (size_t) cnt * keyBits, slotCol = pageCol + (size_t) cnt * pageBits;
+    for (uint i = 0; i < cnt; i++) {
+        int key = (int) ((uint) keyBase + getBits(data, (size_t) i * keyBits, keyBits));
+        TID tid;
+        tid.page = pageBase + getBits(data, pageCol + (size_t) i * pageBits, pageBits);
+        tid.slot = slotBase + getBits(data, slotCol + (size_t) i * slotBits, slotBits);
+        memcpy(out, &key, sizeof(int));
+        memcpy(out + attrTypeSize, &tid, sizeof(TID));
+        out += entrySize;
+    }
+}
+
+/**
+ * Binaere Suche ueber die gepackten Abstaende zu keyBase, nur der Treffer wird entpackt
+ */
+void DBMyIndex::findInPackedLeaf(const char * page, const DBAttrType & val, tidSink & sink) const {
+    const uint * header = (const uint *) page;
+    uint cnt = header[0];
+    const unsigned char * bits = (const unsigned char *) (header + 2);
+    uint keyBits = bits[0], pageBits = bits[1], slotBits = bits[2];
+    const char * ptr = (const char *) (bits + 4);
+    int keyBase;
+    BlockNo pageBase;
+    uint slotBase;
+    memcpy(&keyBase, ptr, sizeof(int));
+    memcpy(&pageBase, ptr + sizeof(int), sizeof(BlockNo));
+    memcpy(&slotBase, ptr + sizeof(int) + sizeof(BlockNo), sizeof(uint));
+    const unsigned char * data = (const unsigned char *) (ptr + sizeof(int) + sizeof(BlockNo) + sizeof(uint));
+
+    char keyBuf[sizeof(int)];
+    val.write(keyBuf);
+    int key;
+    memcpy(&key, keyBuf, sizeof(int));
+    if (cnt == 0 || key < keyBase) {
+        LOG4CXX_DEBUG(logger, "Value not found");
+        return;
+    }
+    long long target = (long long) key - keyBase;
+    if (keyBits < 32 && target >> keyBits != 0) {
+        LOG4CXX_DEBUG(logger, "Value not found");
+        return;
+    }
+
+    uint lo = 0, hi = cnt;
+    while (lo < hi) {
+        uint mid = (lo + hi) / 2;
+        if (getBits(data, (size_t) mid * keyBits, keyBits) < (uint) target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == cnt || getBits(data, (size_t) lo * keyBits, keyBits) != (uint) target) {
+        LOG4CXX_DEBUG(logger, "Value not found");
+        return;
+    }
+    const size_t pageCol = (size_t) cnt * keyBits, slotCol = pageCol + (size_t) cnt * pageBits;
+    TID result;
+    result.page = pageBase + getBits(data, pageCol + (size_t) lo * pageBits, pageBits);
+    result.slot = slotBase + getBits(data, slotCol + (size_t) lo * slotBits, slotBits);
+    LOG4CXX_DEBUG(logger, "Found TID: "+result.toString());
+    sink.put(result);
+}
+
+DBMyIndex::splitInfo DBMyIndex::insertIntoCompressedLeaf(const BlockNo b, const DBAttrType &val, const TID &tid) {
+    LOG4CXX_INFO(logger,"insertIntoCompressedLeaf()");
+    LOG4CXX_DEBUG(logger,"BlockNo: "+TO_STR(b));
+    const uint entrySize = attrTypeSize + sizeof(TID);
+
+    splitInfo returnObject;
+    returnObject.splitHappens = false;
+
+    bacbStack.push(bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE));
+    vector<char> & image = leafImage;
+    decodeLeaf(bacbStack.top().getDataPtr(), image, 1);
+    uint * cnt = (uint *) &image[0];
+    LOG4CXX_DEBUG(logger, "Keys before Insert: "+TO_STR(*cnt));
+
+    const char * ptr = &image[sizeof(uint)];
+    const char * key = keyBytes(val);
+    uint pos = leafSearch(ptr, *cnt, key, attrTypeSize);
+    ptr += (attrTypeSize + sizeof(TID)) * pos;
+    if (pos < *cnt && compareKeys(ptr, key) == 0) {
+        TID existing = *(TID *) (ptr + attrTypeSize);
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        throw DBIndexException("Insert failed, entry already exists with TID "+existing.toString());
+    }
+
+    char * from = &image[sizeof(uint)] + entrySize * pos;
+    memmove(from + entrySize, from, entrySize * (*cnt - pos));
+    memcpy(from, key, attrTypeSize);
+    memcpy(from + attrTypeSize, &tid, sizeof(TID));
+    ++*cnt;
+    LOG4CXX_DEBUG(logger,"Keys after Insert: " + TO_STR(*cnt));
+
+    //erst in Arbeitsseiten kodieren: schlaegt das fehl, bleiben Blatt und freie Seiten unveraendert
+    const uint blockSize = DBFileBlock::getBlockSize();
+    leafScratch.resize(2 * blockSize);
+    char * left = &leafScratch[0];
+    char * right = left + blockSize;
+    if (encodeLeaf(&image[0], 0, *cnt, left) == false) {
+        LOG4CXX_DEBUG(logger,"Compressed Leaf Node full, splitting");
+        //neuer Eintrag am Ende: allein in die neue Seite, der Rest passte schon vorher
+        uint split = pos > 0 && pos == *cnt - 1 ? pos : leafSplitPos(&image[0]);
+        //ein Ausreisser kann eine Haelfte unkomprimierbar machen (gepackt zu breit):
+        //dann den neuen Eintrag vom alten Inhalt trennen, der fuer sich schon passte
+        const uint candidates[3] = {split, pos, pos + 1};
+        bool fits = false;
+        for (uint i = 0; i < 3 && fits == false; i++) {
+            split = candidates[i];
+            fits = split > 0 && split < *cnt && encodeLeaf(&image[0], split, *cnt, right) && encodeLeaf(&image[0], 0, split, left);
+        }
+        if (fits == false) {
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+            throw DBIndexException("Compressed leaf split failed");
+        }
+        returnObject.splitHappens = true;
+
+        bacbStack.push(fixNewPage(b));
+        returnObject.newBlockNo = bacbStack.top().getBlockNo();
+        LOG4CXX_DEBUG(logger,"New Leaf Node BlockNo: " + TO_STR(returnObject.newBlockNo));
+        memcpy(bacbStack.top().getDataPtr(), right, leafVersionOffset());
+        stampLeaf(bacbStack.top().getDataPtr());
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        char * newKey = arena.alloc(attrTypeSize);
+        memcpy(newKey, &image[sizeof(uint)] + entrySize * split, attrTypeSize);
+        returnObject.newKey = newKey;
+        LOG4CXX_DEBUG(logger,"New Leaf Node Key: " + keyToString(returnObject.newKey));
+    }
+
+    memcpy(bacbStack.top().getDataPtr(), left, leafVersionOffset());
+    stampLeaf(bacbStack.top().getDataPtr());
+    bacbStack.top().setModified();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+
+    return returnObject;
+}
+
+/**
+ * Neue Seite fuer einen Knoten. Die Datei waechst in Extents von extentSize
+ * Seiten, der Rest eines Extents bleibt fuer spaetere Splits der Nachbarn frei.
+ * Mit near (Seite des geteilten Knotens) wird eine freie Seite im Abstand eines
+ * Extents genommen, bevorzugt dahinter, so dass benachbarte Blaetter auch auf
+ * der Platte beieinander liegen. Gibt es dort keine, wird ein neuer Extent
+ * begonnen, solange hoechstens ein Viertel der Datei frei ist, sonst (und ohne
+ * near) die kleinste freie Seite wiederverwendet.
+ */
+DBBACB DBMyIndex::fixNewPage(BlockNo near) {
+    assert(spareLoaded);
+    set<BlockNo>::iterator it = sparePages.upper_bound(near);
+    if (near != 0 && (it == sparePages.end() || *it - near >= extentSize)) {
+        set<BlockNo>::iterator before = sparePages.lower_bound(near > extentSize ? near - extentSize + 1 : 1);
+        if (before != sparePages.end() && *before < near)
+            it = before;
+        else if (sparePages.size() * 4 < bufMgr.getBlockCnt(file))
+            return allocateExtent();
+        else
+            it = sparePages.begin();
+    }
+    if (it == sparePages.end())
+        return allocateExtent();
+    BlockNo b = *it;
+    sparePages.erase(it);
+    LOG4CXX_DEBUG(logger,"Reusing free page "+TO_STR(b));
+    DBBACB bacb = bufMgr.fixBlock(file, b, LOCK_EXCLUSIVE);
+    //Cursor auf der frueheren Verwendung der Seite duerfen nicht fortsetzen
+    stampLeaf(bacb.getDataPtr());
+    return bacb;
+}
+
+/**
+ * Haengt extentSize Seiten an die Datei an, liefert die erste fixiert und
+ * vermerkt die uebrigen als frei
+ */
+DBBACB DBMyIndex::allocateExtent() {
+    BlockNo first = 0;
+    for (uint i = 0; i < extentSize; i++) {
+        DBBACB bacb = bufMgr.fixNewBlock(file);
+        if (i == 0)
+            first = bacb.getBlockNo();
+        else
+            sparePages.insert(bacb.getBlockNo());
+        bacb.setModified();
+        bufMgr.unfixBlock(bacb);
+    }
+    LOG4CXX_DEBUG(logger,"New extent at "+TO_STR(first));
+    DBBACB bacb = bufMgr.fixBlock(file, first, LOCK_EXCLUSIVE);
+    stampLeaf(bacb.getDataPtr());
+    return bacb;
+}
+
+/**
+ * Gibt eine nicht mehr erreichbare Seite frei, ohne sie zu fixieren. Cursor
+ * bemerken das am geaenderten releaseCount, wiederverwendet wird die Seite erst
+ * in fixNewPage und dort gestempelt.
+ */
+void DBMyIndex::releasePage(BlockNo b) {
+    sparePages.insert(b);
+    releaseCount++;
+}
+
+/**
+ * Uebernimmt beim ersten schreibenden Zugriff die Freiliste des Metablocks
+ * (oben auf dem bacbStack, exklusiv) in den Hauptspeicher. Die Liste im
+ * Metablock wird dabei geleert, nach einem Absturz gehen freie Seiten nur
+ * verloren, statt doppelt vergeben zu werden.
+ */
+void DBMyIndex::loadSparePages() {
+    if (spareLoaded)
+        return;
+    BlockNo * headPtr = (BlockNo *) ((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+5);
+    for (BlockNo b = *headPtr; b != 0;) {
+        sparePages.insert(b);
+        bacbStack.push(bufMgr.fixBlock(file, b, LOCK_SHARED));
+        b = *(const BlockNo *) bacbStack.top().getDataPtr();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+    }
+    if (*headPtr != 0) {
+        *headPtr = 0;
+        bacbStack.top().setModified();
+    }
+    spareLoaded = true;
+    LOG4CXX_DEBUG(logger,"Free pages: "+TO_STR(sparePages.size()));
+}
+
+/**
+ * Schreibt die freien Seiten als aufsteigend verkettete Liste zurueck
+ * (naechste freie Seite steht am Anfang der Seite)
+ */
+void DBMyIndex::saveSparePages() {
+    BlockNo head = 0;
+    for (set<BlockNo>::reverse_iterator it = sparePages.rbegin(); it != sparePages.rend(); ++it) {
+        bacbStack.push(bufMgr.fixBlock(file, *it, LOCK_EXCLUSIVE));
+        *(BlockNo *) bacbStack.top().getDataPtr() = head;
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        head = *it;
+    }
+    *((BlockNo *) ((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+5)) = head;
+    bacbStack.top().setModified();
+    LOG4CXX_DEBUG(logger,"Saved "+TO_STR(sparePages.size())+" free pages");
+}
+
+/**
+ * Online-Defragmentierung: die Blaetter werden in Schluesselreihenfolge auf
+ * aufsteigende Seiten gelegt. Liegt ein Blatt vor seinem Vorgaenger, wird es auf
+ * eine freie Seite innerhalb eines Extents hinter diesem kopiert oder, wenn es
+ * keine gibt, in einen neuen Extent am Dateiende, an den die folgenden Blaetter
+ * lueckenlos anschliessen. Die alten Seiten werden frei. Jeder unterste innere Knoten wird in einem
+ * eigenen Schreibabschnitt bearbeitet, Leser kommen dazwischen zum Zug. Cursor
+ * auf einem verschobenen Blatt erkennen das am Versionsstempel und steigen neu ab.
+ */
+uint DBMyIndex::defragment() {
+    LOG4CXX_INFO(logger,"defragment()");
+    if (copyOnWrite)
+        throw DBIndexException("Defragmentation is not supported in copy-on-write mode");
+    if (mappedPtr != NULL)
+        throw DBIndexException("Index is mapped read only");
+
+    vector<char> next(attrTypeSize);
+    bool first = true;
+    BlockNo prev = metaBlockNo;
+    uint moved = 0;
+    bool more = true;
+    while (more) {
+        writeScope scope(*this);
+        if (bacbStack.size() != 1)
+            throw DBIndexException("BACB Stack is invalid");
+        if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+            bufMgr.upgradeToExclusive(bacbStack.top());
+        loadSparePages();
+        uint before = moved;
+        more = defragmentBatch(next, first, prev, moved);
+        if (moved != before)
+            countChange();
+    }
+    //das gemerkte rechteste Blatt kann verschoben sein
+    appendLeaf = 0;
+    LOG4CXX_DEBUG(logger,"Leaves moved: "+TO_STR(moved));
+    return moved;
+}
+
+/**
+ * Bearbeitet die Blaetter des untersten inneren Knotens, der next enthaelt (bzw.
+ * des ersten), und setzt next auf dessen rechte Grenze; false, wenn es keinen
+ * weiteren Knoten gibt
+ */
+bool DBMyIndex::defragmentBatch(vector<char> & next, bool & first, BlockNo & prev, uint & moved) {
+    char * metaPtr = bacbStack.top().getDataPtr();
+    BlockNo b = *(BlockNo *) metaPtr;
+    uint depth = *((uint *) metaPtr+sizeof(BlockNo));
+    //ein einzelnes Blatt ist immer geordnet
+    if (depth == 0)
+        return false;
+
+    const uint pairSize = attrTypeSize + sizeof(BlockNo);
+    vector<char> fence(attrTypeSize);
+    bool fenced = false;
+    uint k = 0;
+    for (uint d = 0; d < depth; d++) {
+        bool bottom = d + 1 == depth;
+        bacbStack.push(bufMgr.fixBlock(file, b, bottom ? LOCK_EXCLUSIVE : LOCK_SHARED));
+        const char * page = bacbStack.top().getDataPtr();
+        uint cnt = *(const uint *) page;
+        k = first ? 0 : innerSearch(page + sizeof(uint) + sizeof(BlockNo), cnt, &next[0], attrTypeSize);
+        if (bottom)
+            break;
+        //rechte Grenze des Teilbaums; der unterste Knoten wird bis zum Ende bearbeitet
+        if (k < cnt) {
+            memcpy(&fence[0], page + sizeof(uint) + sizeof(BlockNo) + pairSize * k, attrTypeSize);
+            fenced = true;
+        }
+        b = *(const BlockNo *) (page + sizeof(uint) + pairSize * k);
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+    }
+
+    char * page = bacbStack.top().getDataPtr();
+    uint cnt = *(uint *) page;
+    for (; k <= cnt; k++) {
+        BlockNo * child = (BlockNo *) (page + sizeof(uint) + pairSize * k);
+        BlockNo leaf = *child;
+        //Blaetter hinter ihrem Vorgaenger bleiben, auch mit Luecke; ein zweiter Lauf verschiebt nichts
+        if (leaf > prev) {
+            prev = leaf;
+            continue;
+        }
+        set<BlockNo>::iterator it = sparePages.upper_bound(prev);
+        if (it == sparePages.end() || *it - prev > extentSize) {
+            bacbStack.push(allocateExtent());
+        } else {
+            bacbStack.push(bufMgr.fixBlock(file, *it, LOCK_EXCLUSIVE));
+            sparePages.erase(it);
+        }
+        BlockNo target = bacbStack.top().getBlockNo();
+        char * targetPtr = bacbStack.top().getDataPtr();
+        bacbStack.push(bufMgr.fixBlock(file, leaf, LOCK_SHARED));
+        //der Stempel der Zielseite zaehlt weiter, alte Cursor auf ihr setzen nicht fort
+        memcpy(targetPtr, bacbStack.top().getDataPtr(), leafVersionOffset());
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        stampLeaf(targetPtr);
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+
+        *child = target;
+        bacbStack.top().setModified();
+        releasePage(leaf);
+        LOG4CXX_DEBUG(logger,"Moved leaf "+TO_STR(leaf)+" to "+TO_STR(target));
+        prev = target;
+        moved++;
+    }
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    first = false;
+    next.swap(fence);
+    return fenced;
+}
+
+/**
+ * Copy-on-write mode: veroeffentlichte Seiten werden nie geaendert. Vor jeder
+ * Aenderung kopiert copyPath den Pfad von der Wurzel zum Blatt von val in neue
+ * Seiten, traegt die neue Wurzel im Metablock ein und liefert die BlockNo des
+ * kopierten Blatts; Splits entstehen ohnehin in neuen Seiten. Die alten
+ * Pfadseiten werden mit der Epoche der Aenderung als ausgemustert vermerkt und
+ * erst wiederverwendet, wenn kein Snapshot mit aelterer Epoche mehr aktiv ist.
+ */
+BlockNo DBMyIndex::copyPath(const DBAttrType &val) {
+    LOG4CXX_INFO(logger,"copyPath()");
+    char * metaPtr = bacbStack.top().getDataPtr();
+    BlockNo * rootPtr = (BlockNo *) metaPtr;
+    uint depth = *((uint *) metaPtr+sizeof(BlockNo));
+
+    const uint pairSize = sizeof(BlockNo) + attrTypeSize;
+    const char * key = keyBytes(val);
+    BlockNo parent = 0;
+    uint pos = 0;
+    BlockNo b = *rootPtr;
+    for (uint i = 0; i <= depth; i++) {
+        if (i > 0) {
+            //die Kindposition gilt auch im kopierten Elternknoten
+            bacbStack.push(bufMgr.fixBlock(file, parent, LOCK_SHARED));
+            const char * page = bacbStack.top().getDataPtr();
+            pos = innerSearch(page + sizeof(uint) + sizeof(BlockNo), *(const uint *) page, key, attrTypeSize);
+            b = *(const BlockNo *) (page + sizeof(uint) + pairSize * pos);
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+        }
+        bool leaf = i == depth;
+        bacbStack.push(bufMgr.fixBlock(file, b, leaf ? LOCK_EXCLUSIVE : LOCK_SHARED));
+        char * oldPtr = bacbStack.top().getDataPtr();
+        //jede Aenderung verlegt den Pfad ohnehin, freie Seiten werden ohne Naehe vergeben
+        bacbStack.push(fixNewPage());
+        BlockNo copy = bacbStack.top().getBlockNo();
+        //die Kopie behaelt den Versionsstempel ihrer Seite
+        memcpy(bacbStack.top().getDataPtr(), oldPtr, leaf ? leafVersionOffset() : DBFileBlock::getBlockSize());
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        if (leaf) {
+            //Snapshot-Leser pruefen den Stempel nicht, fortgesetzte Cursor steigen neu ab
+            stampLeaf(oldPtr);
+            bacbStack.top().setModified();
+        }
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        retired.push_back(make_pair(epoch + 1, b));
+
+        if (i == 0) {
+            *rootPtr = copy;
+            bacbStack.top().setModified();
+        } else {
+            //Zeiger im kopierten Elternknoten umhaengen
+            bacbStack.push(bufMgr.fixBlock(file, parent, LOCK_EXCLUSIVE));
+            BlockNo * child = (BlockNo *) (bacbStack.top().getDataPtr() + sizeof(uint) + pairSize * pos);
+            assert(*child == b);
+            *child = copy;
+            bacbStack.top().setModified();
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+        }
+        LOG4CXX_DEBUG(logger,"Copied "+TO_STR(b)+" to "+TO_STR(copy));
+        parent = copy;
+    }
+    return parent;
+}
+/**
+ * Schliesst eine Aenderung ab: neue Epoche und Freiliste in den Metablock
+ */
+void DBMyIndex::commitCopy() {
+    epoch++;
+    reclaimPages();
+    LOG4CXX_DEBUG(logger,"Committed epoch "+TO_STR(epoch));
+}
+
+/**
+ * Gibt ausgemusterte Seiten frei, die kein aktiver Snapshot mehr sehen kann
+ */
+void DBMyIndex::reclaimPages() {
+    loadSparePages();
+    uint oldestPinned = pinned.empty() ? epoch : pinned.begin()->first;
+    uint kept = 0;
+    for (uint i = 0; i < retired.size(); i++) {
+        //eine in Epoche e ausgemusterte Seite war bis Epoche e-1 erreichbar
+        if (retired[i].first <= oldestPinned) {
+            sparePages.insert(retired[i].second);
+        } else {
+            retired[kept++] = retired[i];
+        }
+    }
+    retired.resize(kept);
+
+    uint * metaPage = (uint *) bacbStack.top().getDataPtr() + sizeof(BlockNo);
+    *(metaPage+4) = epoch;
+    bacbStack.top().setModified();
+}
+
+/**
+ * Merkt sich Wurzel und Epoche des aktuellen Stands. Bis zu endSnapshot()
+ * werden die Seiten dieses Stands nicht wiederverwendet, find() mit dem
+ * Snapshot braucht weder den Metablock noch kollidiert es mit Schreibern.
+ */
+DBMyIndex::snapshotInfo DBMyIndex::beginSnapshot() {
+    LOG4CXX_INFO(logger,"beginSnapshot()");
+    writeScope scope(*this);
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (copyOnWrite == false)
+        throw DBIndexException("Snapshots need copy-on-write mode");
+    char * metaPtr = bacbStack.top().getDataPtr();
+    snapshotInfo snapshot;
+    snapshot.root = *(BlockNo *) metaPtr;
+    snapshot.depth = *((uint *) metaPtr+sizeof(BlockNo));
+    snapshot.epoch = epoch;
+    pinned[epoch]++;
+    LOG4CXX_DEBUG(logger,"Snapshot root "+TO_STR(snapshot.root)+", epoch "+TO_STR(snapshot.epoch));
+    return snapshot;
+}
+
+void DBMyIndex::find(const DBAttrType &val, DBListTID &tids, const snapshotInfo &snapshot) {
+    LOG4CXX_INFO(logger,"find(snapshot)");
+    LOG4CXX_DEBUG(logger,"val:\n"+val.toString("\t"));
+    tids.clear();
+    if (shared) {
+        rangeCursor cursor = openRange(val, val, snapshot);
+        TID tid;
+        while (nextInRange(cursor, tid))
+            tids.push_back(tid);
+        return;
+    }
+    if (pinned.find(snapshot.epoch) == pinned.end())
+        throw DBIndexException("Snapshot is not active");
+
+    arenaScope scope(arena);
+    BlockNo b = snapshot.root;
+    for (uint i = 0; i < snapshot.depth; i++)
+        b = findInInnerNode(val, b);
+    tidListSink sink(tids);
+    findInLeafNode(val, b, sink);
+}
+
+void DBMyIndex::endSnapshot(const snapshotInfo &snapshot) {
+    LOG4CXX_INFO(logger,"endSnapshot()");
+    writeScope scope(*this);
+    map<uint,uint>::iterator it = pinned.find(snapshot.epoch);
+    if (it == pinned.end())
+        throw DBIndexException("Snapshot is not active");
+    if (--it->second == 0)
+        pinned.erase(it);
+    if (bacbStack.size() == 1 && retired.empty() == false)
+        reclaimPages();
+}
+
+/**
+ * Paralleler Aufbau eines leeren Index aus (key, TID)-Paaren:
+ * - Datensaetze fester Laenge (key, TID) werden in threadCnt Abschnitten parallel sortiert
+ *   und paarweise parallel gemischt
+ * - Worker kodieren die Blaetter disjunkter Schluesselbereiche, der aufrufende Thread
+ *   schreibt die Seiten und baut die inneren Ebenen von unten nach oben auf
+ * Der Buffermanager wird nur vom aufrufenden Thread benutzt.
+ */
+namespace {
+    //Vergleich serialisierter Schluessel ohne DBAttrType-Objekte
+    int compareKeyBytes(const char * a, const char * b, enum AttrTypeEnum attrType, uint attrTypeSize) {
+        if (attrType == INT)
+            return keyTraits<INT>::compare(a, b, attrTypeSize);
+        else if (attrType == DOUBLE)
+            return keyTraits<DOUBLE>::compare(a, b, attrTypeSize);
+        return keyTraits<VCHAR>::compare(a, b, attrTypeSize);
+    }
+
+    struct recordLess {
+        const char * records;
+        uint recordSize;
+        enum AttrTypeEnum attrType;
+        uint attrTypeSize;
+
+        int compare(uint a, uint b) const {
+            return compareKeyBytes(records + (size_t) a * recordSize, records + (size_t) b * recordSize, attrType, attrTypeSize);
+        }
+        bool operator()(uint a, uint b) const { return compare(a, b) < 0; }
+    };
+
+    struct bulkTask {
+        const DBMyIndex * index;
+        recordLess less;
+        vector<uint> * order;
+        vector<uint> * mergeTarget;
+        size_t from, mid, to;
+        const char * image;
+        vector<vector<char> > pages;
+        vector<size_t> firstEntries;
+    };
+
+    void runTasks(vector<bulkTask> & tasks, void * (*fn)(void *)) {
+        vector<pthread_t> threads(tasks.size());
+        for (uint i = 0; i < tasks.size(); i++) {
+            if (pthread_create(&threads[i], NULL, fn, &tasks[i]) != 0)
+                throw DBIndexException("Could not start bulk load thread");
+        }
+        for (uint i = 0; i < tasks.size(); i++)
+            pthread_join(threads[i], NULL);
+    }
+}
+
+void * DBMyIndex::bulkSortWorker(void * arg) {
+    bulkTask * task = (bulkTask *) arg;
+    sort(task->order->begin() + task->from, task->order->begin() + task->to, task->less);
+    return NULL;
+}
+
+void * DBMyIndex::bulkMergeWorker(void * arg) {
+    bulkTask * task = (bulkTask *) arg;
+    merge(task->order->begin() + task->from, task->order->begin() + task->mid,
+          task->order->begin() + task->mid, task->order->begin() + task->to,
+          task->mergeTarget->begin() + task->from, task->less);
+    return NULL;
+}
+
+/**
+ * Kodiert die Eintraege [from, to) des sortierten Abbilds in Blattseiten: unkomprimiert
+ * jeweils keysPerLeafNode() Eintraege, komprimiert so viele, wie in die Seite passen
+ */
+void * DBMyIndex::bulkLeafWorker(void * arg) {
+    bulkTask * task = (bulkTask *) arg;
+    const DBMyIndex * index = task->index;
+    const uint entrySize = index->attrTypeSize + sizeof(TID);
+    const uint blockSize = DBFileBlock::getBlockSize();
+
+    vector<size_t> counts;
+    for (size_t pos = task->from; pos < task->to;) {
+        size_t n = min((size_t) index->keysPerLeafNode(), task->to - pos);
+        if (index->leafFormat != LEAF_PLAIN) {
+            //groesste passende Anzahl per exponentieller und binaerer Suche
+            vector<char> page(blockSize);
+            size_t lo = 1, hi = 1;
+            while (pos + hi <= task->to && index->encodeLeaf(task->image, pos, pos + hi, &page[0])) {
+                lo = hi;
+                hi *= 2;
+            }
+            hi = min(hi, task->to - pos + 1);
+            while (lo + 1 < hi) {
+                size_t m = (lo + hi) / 2;
+                if (index->encodeLeaf(task->image, pos, pos + m, &page[0]))
+                    lo = m;
+                else
+                    hi = m;
+            }
+            n = lo;
+        }
+        counts.push_back(n);
+        pos += n;
+    }
+    size_t pos = task->from;
+    for (uint i = 0; i < counts.size(); i++) {
+        task->pages.push_back(vector<char>(blockSize, 0));
+        char * page = &task->pages.back()[0];
+        if (index->leafFormat == LEAF_PLAIN) {
+            *(uint *) page = counts[i];
+            memcpy(page + sizeof(uint), task->image + sizeof(uint) + entrySize * pos, entrySize * counts[i]);
+        } else {
+            index->encodeLeaf(task->image, pos, pos + counts[i], page);
+        }
+        task->firstEntries.push_back(pos);
+        pos += counts[i];
+    }
+    return NULL;
+}
+
+/**
+ * Gleicht das Blatt right mit seinem linken Nachbarn aus, wenn eines der beiden
+ * unterbelegt ist: unkomprimiert weniger als keysPerLeafNode()/2 Eintraege,
+ * komprimiert weniger als halb so viele wie der Nachbar. Die beiden Blaetter
+ * decken [firstEntries[right - 1], end) ab. Passt alles in ein Blatt (komprimiert
+ * immer versucht), wird right entfernt (true); sonst wird die Grenze zur Mitte verschoben, komprimiert nur so
+ * weit, wie beide Seiten noch passen.
+ */
+bool DBMyIndex::balanceBulkLeaves(const char * image, vector<vector<char> > & pages, vector<size_t> & firstEntries, size_t right, size_t end) const {
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    size_t from = firstEntries[right - 1], split = firstEntries[right];
+    size_t leftCnt = split - from, rightCnt = end - split;
+    size_t mid = from + (end - from + 1) / 2;
+    if (leafFormat == LEAF_PLAIN) {
+        if (leftCnt >= keysPerLeafNode() / 2 && rightCnt >= keysPerLeafNode() / 2)
+            return false;
+        split = end - from <= keysPerLeafNode() ? end : mid;
+        for (size_t p = right - 1; p <= right; p++) {
+            size_t first = p == right ? split : from, last = p == right ? end : split;
+            *(uint *) &pages[p][0] = last - first;
+            memcpy(&pages[p][sizeof(uint)], image + sizeof(uint) + entrySize * first, entrySize * (last - first));
+        }
+    } else {
+        vector<char> leftPage(DBFileBlock::getBlockSize()), rightPage(DBFileBlock::getBlockSize());
+        size_t candidate = end;
+        if (encodeLeaf(image, from, end, &leftPage[0]) == false) {
+            if (leftCnt * 2 >= rightCnt && rightCnt * 2 >= leftCnt)
+                return false;
+            candidate = mid;
+        }
+        //Abstand zur bisherigen (passenden) Grenze halbieren, bis beide Seiten passen
+        while (candidate != split && candidate != end) {
+            if (encodeLeaf(image, from, candidate, &leftPage[0]) && encodeLeaf(image, candidate, end, &rightPage[0]))
+                break;
+            candidate = candidate > split ? split + (candidate - split) / 2 : split - (split - candidate) / 2;
+        }
+        if (candidate == split)
+            return false;
+        split = candidate;
+        memcpy(&pages[right - 1][0], &leftPage[0], leafVersionOffset());
+        if (split < end)
+            memcpy(&pages[right][0], &rightPage[0], leafVersionOffset());
+    }
+    if (split == end) {
+        pages.erase(pages.begin() + right);
+        firstEntries.erase(firstEntries.begin() + right);
+        return true;
+    }
+    firstEntries[right] = split;
+    return false;
+}
+
+void DBMyIndex::bulkLoad(const vector<const DBAttrType *> & keys, const vector<TID> & tids, uint threadCnt) {
+    if (partial)
+        throw DBIndexException("Partial index needs the predicate result of the tuples");
+    bulkLoad(keys, tids, vector<bool>(keys.size(), true), threadCnt);
+}
+
+/**
+ * Bulk Load mit dem vom Aufrufer je Tupel ausgewerteten Praedikat (qualifies
+ * parallel zu keys und tids); beim partiellen Index fallen nicht
+ * qualifizierende Tupel vor dem Sortieren weg.
+ */
+void DBMyIndex::bulkLoad(const vector<const DBAttrType *> & allKeys, const vector<TID> & allTids, const vector<bool> & qualifies, uint threadCnt) {
+    LOG4CXX_INFO(logger,"bulkLoad()");
+    LOG4CXX_DEBUG(logger,"entries: "+TO_STR(allKeys.size())+", threads: "+TO_STR(threadCnt));
+    writeScope scope(*this);
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (mappedPtr != NULL)
+        throw DBIndexException("Index is mapped read only");
+    if (allKeys.size() != allTids.size() || allKeys.size() != qualifies.size())
+        throw DBIndexException("Number of keys, TIDs and predicate results differ");
+
+    //partieller Index: nicht qualifizierende Eintraege fallen weg
+    vector<const DBAttrType *> partialKeys;
+    vector<TID> partialTids;
+    if (partial) {
+        for (size_t i = 0; i < allKeys.size(); i++) {
+            if (qualifies[i]) {
+                partialKeys.push_back(allKeys[i]);
+                partialTids.push_back(allTids[i]);
+            }
+        }
+        LOG4CXX_DEBUG(logger,"entries covered by the partial index: "+TO_STR(partialKeys.size()));
+    }
+    const vector<const DBAttrType *> & keys = partial ? partialKeys : allKeys;
+    const vector<TID> & tids = partial ? partialTids : allTids;
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+    loadSparePages();
+
+    char * metaPtr = bacbStack.top().getDataPtr();
+    BlockNo rootBlockNo = *(BlockNo *) metaPtr;
+    if (*((uint *) metaPtr+sizeof(BlockNo)) != 0)
+        throw DBIndexException("Bulk load needs an empty index");
+    bacbStack.push(bufMgr.fixBlock(file, rootBlockNo, LOCK_SHARED));
+    uint rootCnt = *(uint *) bacbStack.top().getDataPtr();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    if (rootCnt != 0)
+        throw DBIndexException("Bulk load needs an empty index");
+    if (keys.empty())
+        return;
+    appendLeaf = 0;
+
+    threadCnt = max(1u, min(threadCnt, (uint) keys.size()));
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const size_t n = keys.size();
+
+    //Datensaetze im Format eines unkomprimierten Blatts: | uint cnt | (key, TID) * cnt |
+    vector<char> records(sizeof(uint) + entrySize * n);
+    *(uint *) &records[0] = n;
+    for (size_t i = 0; i < n; i++) {
+        char * ptr = keys[i]->write(&records[sizeof(uint) + entrySize * i]);
+        memcpy(ptr, &tids[i], sizeof(TID));
+    }
+
+    //parallel sortieren und paarweise mischen
+    recordLess less;
+    less.records = &records[sizeof(uint)];
+    less.recordSize = entrySize;
+    less.attrType = attrType;
+    less.attrTypeSize = attrTypeSize;
+    vector<uint> order(n), merged(n);
+    for (size_t i = 0; i < n; i++)
+        order[i] = i;
+
+    vector<size_t> bounds;
+    for (uint t = 0; t <= threadCnt; t++)
+        bounds.push_back(n * t / threadCnt);
+    vector<bulkTask> tasks(threadCnt);
+    for (uint t = 0; t < threadCnt; t++) {
+        tasks[t].less = less;
+        tasks[t].order = &order;
+        tasks[t].from = bounds[t];
+        tasks[t].to = bounds[t + 1];
+    }
+    runTasks(tasks, bulkSortWorker);
+
+    while (bounds.size() > 2) {
+        vector<size_t> nextBounds;
+        tasks.clear();
+        for (uint i = 0; i + 1 < bounds.size(); i += 2) {
+            nextBounds.push_back(bounds[i]);
+            bulkTask task;
+            task.less = less;
+            task.order = &order;
+            task.mergeTarget = &merged;
+            task.from = bounds[i];
+            //ein uebriger Abschnitt ohne Partner wird nur umkopiert
+            task.mid = bounds[i + 1];
+            task.to = i + 2 < bounds.size() ? bounds[i + 2] : bounds[i + 1];
+            tasks.push_back(task);
+        }
+        nextBounds.push_back(n);
+        runTasks(tasks, bulkMergeWorker);
+        order.swap(merged);
+        bounds.swap(nextBounds);
+    }
+
+    for (size_t i = 1; i < n; i++) {
+        if (less.compare(order[i - 1], order[i]) == 0) {
+            DBAttrType * dup = DBAttrType::read(&records[sizeof(uint) + entrySize * order[i]], attrType);
+            string dupStr = dup->toString();
+            delete dup;
+            throw DBIndexException("Bulk load failed, duplicate key "+dupStr);
+        }
+    }
+
+    vector<char> image(sizeof(uint) + entrySize * n);
+    *(uint *) &image[0] = n;
+    for (size_t i = 0; i < n; i++)
+        memcpy(&image[sizeof(uint) + entrySize * i], &records[sizeof(uint) + entrySize * order[i]], entrySize);
+    vector<char>().swap(records);
+
+    //Blaetter disjunkter Bereiche parallel kodieren
+    tasks.assign(threadCnt, bulkTask());
+    for (uint t = 0; t < threadCnt; t++) {
+        tasks[t].index = this;
+        tasks[t].image = &image[0];
+        tasks[t].from = n * t / threadCnt;
+        tasks[t].to = n * (t + 1) / threadCnt;
+    }
+    runTasks(tasks, bulkLeafWorker);
+
+    //jeder Abschnitt endet mit einem Rest-Blatt: mit dem ersten Blatt des naechsten
+    //Abschnitts (bzw. beim letzten mit dem Vorgaenger) ausgleichen
+    vector<vector<char> > pages;
+    vector<size_t> firstEntries;
+    vector<size_t> sliceStarts;
+    for (uint t = 0; t < threadCnt; t++) {
+        if (tasks[t].pages.empty())
+            continue;
+        sliceStarts.push_back(pages.size());
+        for (uint i = 0; i < tasks[t].pages.size(); i++) {
+            pages.push_back(vector<char>());
+            pages.back().swap(tasks[t].pages[i]);
+            firstEntries.push_back(tasks[t].firstEntries[i]);
+        }
+        vector<vector<char> >().swap(tasks[t].pages);
+    }
+    size_t dropped = 0;
+    for (uint t = 1; t < sliceStarts.size(); t++) {
+        size_t right = sliceStarts[t] - dropped;
+        if (balanceBulkLeaves(&image[0], pages, firstEntries, right, right + 1 < pages.size() ? firstEntries[right + 1] : n))
+            dropped++;
+    }
+    if (pages.size() > 1)
+        balanceBulkLeaves(&image[0], pages, firstEntries, pages.size() - 1, n);
+
+    //Blaetter schreiben, das erste ersetzt die leere Wurzel
+    vector<pair<BlockNo, size_t> > level;
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (level.empty())
+            bacbStack.push(bufMgr.fixBlock(file, rootBlockNo, LOCK_EXCLUSIVE));
+        else
+            bacbStack.push(fixNewPage(level.back().first));
+        memcpy(bacbStack.top().getDataPtr(), &pages[i][0], leafVersionOffset());
+        stampLeaf(bacbStack.top().getDataPtr());
+        level.push_back(make_pair(bacbStack.top().getBlockNo(), firstEntries[i]));
+        bacbStack.top().setModified();
+        bufMgr.unfixBlock(bacbStack.top());
+        bacbStack.pop();
+        vector<char>().swap(pages[i]);
+    }
+    LOG4CXX_DEBUG(logger,"Leaves written: "+TO_STR(level.size()));
+
+    //innere Ebenen, Schluessel ist jeweils der kleinste Schluessel des rechten Teilbaums
+    uint depth = 0;
+    const uint fanout = keysPerInnerNode() + 1;
+    while (level.size() > 1) {
+        vector<pair<BlockNo, size_t> > upper;
+        for (size_t i = 0; i < level.size();) {
+            size_t children = min((size_t) fanout, level.size() - i);
+            //der letzte Knoten bekommt mindestens keysPerInnerNode()/2 Schluessel,
+            //sonst die restlichen Kinder auf die letzten beiden Knoten verteilen
+            size_t rest = level.size() - i - children;
+            if (rest > 0 && rest < keysPerInnerNode() / 2 + 1)
+                children = (level.size() - i) - (level.size() - i) / 2;
+            bacbStack.push(fixNewPage(upper.empty() ? 0 : upper.back().first));
+            char * ptr = bacbStack.top().getDataPtr();
+            *(uint *) ptr = children - 1;
+            ptr += sizeof(uint);
+            memcpy(ptr, &level[i].first, sizeof(BlockNo));
+            ptr += sizeof(BlockNo);
+            for (size_t c = 1; c < children; c++) {
+                memcpy(ptr, &image[sizeof(uint) + entrySize * level[i + c].second], attrTypeSize);
+                ptr += attrTypeSize;
+                memcpy(ptr, &level[i + c].first, sizeof(BlockNo));
+                ptr += sizeof(BlockNo);
+            }
+            if (buffered)
+                *(uint *) (bacbStack.top().getDataPtr() + innerBufferOffset()) = 0;
+            upper.push_back(make_pair(bacbStack.top().getBlockNo(), level[i].second));
+            bacbStack.top().setModified();
+            bufMgr.unfixBlock(bacbStack.top());
+            bacbStack.pop();
+            i += children;
+        }
+        level.swap(upper);
+        depth++;
+    }
+
+    *(BlockNo *) metaPtr = level[0].first;
+    *((uint *) metaPtr+sizeof(BlockNo)) = depth;
+    bacbStack.top().setModified();
+    countChange();
+    if (filterBits != 0)
+        buildFilter();
+    LOG4CXX_DEBUG(logger,"Bulk load done, root "+TO_STR(level[0].first)+", depth "+TO_STR(depth));
+}
+
+/**
+ * Online-Aufbau eines Index auf einer Tabelle, in die weiter geschrieben wird:
+ * - beginOnlineBuild(): ab jetzt landen insert/remove nur im Nebenprotokoll
+ *   (| char op | key | TID |), der Baum bleibt fuer den Aufbau reserviert
+ * - der Aufbauende liest die Tabelle und uebergibt sie an bulkLoad(); Schreiber
+ *   warten dabei nicht (im shared mode auch nicht auf den Latch)
+ * - endOnlineBuild(): Protokoll in Runden nachfahren, waehrend es weiter
+ *   waechst; nur der letzte, kleine Rest wird mit gesperrtem Protokoll
+ *   angewendet, danach gehen Aenderungen wieder direkt in den Baum
+ * Der Scan darf Zeilen sehen, die auch im Protokoll stehen: Einfuegen einer
+ * schon vorhandenen TID und Loeschen einer fehlenden TID werden uebersprungen.
+ * Bis endOnlineBuild() zurueckkehrt, ist der Index fuer Suchen unvollstaendig.
+ */
+void DBMyIndex::beginOnlineBuild() {
+    LOG4CXX_INFO(logger,"beginOnlineBuild()");
+    if (mappedPtr != NULL)
+        throw DBIndexException("Index is mapped read only");
+    pthread_mutex_lock(&buildLock);
+    if (buildFailed) {
+        pthread_mutex_unlock(&buildLock);
+        throw DBIndexException("Online build failed, index has to be rebuilt");
+    }
+    if (building) {
+        pthread_mutex_unlock(&buildLock);
+        throw DBIndexException("Online build already in progress");
+    }
+    sideLog.clear();
+    __atomic_store_n(&building, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&buildLock);
+}
+
+/**
+ * Bei einem doppelten Schluessel (zwei TIDs, von denen der Scan die eine und das
+ * Protokoll die andere liefert) bricht der Aufbau mit DBIndexException ab. Baum
+ * und Protokoll passen dann nicht mehr zusammen: der Aufbau wird beendet, der
+ * Index als unbrauchbar markiert (insert/remove werfen) und muss neu angelegt
+ * werden.
+ */
+void DBMyIndex::endOnlineBuild() {
+    LOG4CXX_INFO(logger,"endOnlineBuild()");
+    const uint entrySize = sizeof(char) + attrTypeSize + sizeof(TID);
+    if (__atomic_load_n(&building, __ATOMIC_ACQUIRE) == false)
+        throw DBIndexException("No online build in progress");
+
+    vector<char> batch;
+    bool locked = false;
+    try {
+        //Aufholen ohne die Schreiber aufzuhalten, begrenzt, falls sie schneller sind
+        for (uint round = 0; round < catchUpRounds; round++) {
+            pthread_mutex_lock(&buildLock);
+            if (sideLog.size() <= catchUpEntries * entrySize) {
+                pthread_mutex_unlock(&buildLock);
+                break;
+            }
+            batch.swap(sideLog);
+            pthread_mutex_unlock(&buildLock);
+            LOG4CXX_DEBUG(logger,"catch up round "+TO_STR(round)+": "+TO_STR(batch.size() / entrySize)+" changes");
+            applySideLog(batch);
+            batch.clear();
+        }
+
+        //kurze exklusive Phase: Schreiber warten in logChange() auf das Protokoll
+        pthread_mutex_lock(&buildLock);
+        locked = true;
+        batch.swap(sideLog);
+        LOG4CXX_DEBUG(logger,"final phase: "+TO_STR(batch.size() / entrySize)+" changes");
+        applySideLog(batch);
+    } catch (DBException & e) {
+        if (locked == false)
+            pthread_mutex_lock(&buildLock);
+        LOG4CXX_ERROR(logger,"online build failed, index has to be rebuilt");
+        sideLog.clear();
+        //vor building, damit Schreiber ohne Protokoll den Fehler sicher sehen
+        __atomic_store_n(&buildFailed, true, __ATOMIC_RELEASE);
+        __atomic_store_n(&building, false, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&buildLock);
+        throw;
+    }
+    __atomic_store_n(&building, false, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&buildLock);
+}
+
+/**
+ * Schreibt eine Aenderung ins Nebenprotokoll, falls gerade ein Online-Aufbau
+ * laeuft; false: Aenderung muss direkt im Baum erfolgen. Nach einem
+ * gescheiterten Aufbau wird jede Aenderung abgewiesen.
+ */
+bool DBMyIndex::logChange(char op, const DBAttrType &val, const TID &tid) {
+    if (__atomic_load_n(&building, __ATOMIC_ACQUIRE) == false) {
+        if (__atomic_load_n(&buildFailed, __ATOMIC_ACQUIRE))
+            throw DBIndexException("Online build failed, index has to be rebuilt");
+        return false;
+    }
+    pthread_mutex_lock(&buildLock);
+    bool logged = building;
+    bool failed = buildFailed;
+    if (logged) {
+        size_t pos = sideLog.size();
+        sideLog.resize(pos + sizeof(char) + attrTypeSize + sizeof(TID));
+        sideLog[pos] = op;
+        val.write(&sideLog[pos + sizeof(char)]);
+        memcpy(&sideLog[pos + sizeof(char) + attrTypeSize], &tid, sizeof(TID));
+    }
+    pthread_mutex_unlock(&buildLock);
+    if (failed)
+        throw DBIndexException("Online build failed, index has to be rebuilt");
+    if (logged) {
+        LOG4CXX_DEBUG(logger,"change logged for online build");
+    }
+    return logged;
+}
+
+void DBMyIndex::applySideLog(const vector<char> & log) {
+    LOG4CXX_INFO(logger,"applySideLog()");
+    const uint entrySize = sizeof(char) + attrTypeSize + sizeof(TID);
+    writeScope scope(*this);
+
+    // ein Block muss geblockt sein
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+    loadSparePages();
+
+    //Reihenfolge bleibt erhalten: Einfuegen und spaeteres Loeschen derselben Zeile heben sich auf
+    for (size_t i = 0; i < log.size(); i += entrySize) {
+        arenaScope opScope(arena);
+        DBAttrType * key = DBAttrType::read(&log[i + sizeof(char)], attrType);
+        TID tid;
+        memcpy(&tid, &log[i + sizeof(char) + attrTypeSize], sizeof(TID));
+        firstTidSink existing;
+        lookup(*key, existing);
+        if (log[i] == MSG_INSERT) {
+            if (existing.found && !(existing.tid == tid)) {
+                string keyStr = key->toString();
+                delete key;
+                throw DBIndexException("Online build failed, duplicate key "+keyStr);
+            }
+            if (existing.found == false)
+                insertEntry(*key, tid);
+        } else if (existing.found && existing.tid == tid) {
+            removeEntry(*key, DBListTID(1, tid));
+        }
+        delete key;
+    }
+
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+}
+
+int DBMyIndex::compareKeys(const char * a, const char * b) const {
+    return compareKeyBytes(a, b, attrType, attrTypeSize);
+}
+
+//serialisiert val einmal pro Aufruf in den opArena, verglichen wird danach bytweise
+const char * DBMyIndex::keyBytes(const DBAttrType &val) {
+    char * key = arena.alloc(attrTypeSize);
+    val.write(key);
+    return key;
+}
+
+string DBMyIndex::keyToString(const char * key) const {
+    DBAttrType * attr = DBAttrType::read(key, attrType);
+    string str = attr->toString();
+    delete attr;
+    return str;
+}
+
+/**
+ * Bump-Allokator: Bloecke werden nur beim ersten Bedarf angelegt und danach
+ * wiederverwendet, im eingeschwungenen Zustand gibt es keine Heapzugriffe
+ */
+DBMyIndex::opArena::~opArena() {
+    for (uint i = 0; i < chunks.size(); i++)
+        delete [] chunks[i];
+}
+
+char * DBMyIndex::opArena::alloc(uint size) {
+    while (chunk < chunks.size() && used + size > sizes[chunk]) {
+        chunk++;
+        used = 0;
+    }
+    if (chunk == chunks.size()) {
+        uint chunkSize = max(size, (uint) DBFileBlock::getBlockSize());
+        chunks.push_back(new char[chunkSize]);
+        sizes.push_back(chunkSize);
+    }
+    char * ptr = chunks[chunk] + used;
+    used += size;
+    return ptr;
+}
+
+void DBMyIndex::pathStack::push(BlockNo b) {
+    if (cnt > maxDepth)
+        throw DBIndexException("Tree depth exceeds "+TO_STR(maxDepth));
+    blocks[cnt++] = b;
+}
+
+/**
+ * Legt das Praedikat eines partiellen Index fest. Der Index wertet es nicht
+ * selbst aus: Schreiber uebergeben das Ergebnis je Tupel (qualifies), der
+ * Metablock haelt nur den Praedikatstext als Identitaet fuer den Planer.
+ * Layout hinter der Schliessmarke: | uint Laenge | Zeichen |
+ */
+void DBMyIndex::definePredicate(const string &predicate) {
+    LOG4CXX_INFO(logger,"definePredicate()");
+    LOG4CXX_DEBUG(logger,"predicate: "+predicate);
+    writeScope scope(*this);
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    if (mappedPtr != NULL)
+        throw DBIndexException("Index is mapped read only");
+    if (predicate.empty())
+        throw DBIndexException("Predicate is empty");
+    if (bacbStack.top().getLockMode() != LOCK_EXCLUSIVE)
+        bufMgr.upgradeToExclusive(bacbStack.top());
+
+    char * metaPtr = bacbStack.top().getDataPtr();
+    if (*((uint *) metaPtr+sizeof(BlockNo)) != 0)
+        throw DBIndexException("Predicate needs an empty index");
+    bacbStack.push(bufMgr.fixBlock(file, *(BlockNo *) metaPtr, LOCK_SHARED));
+    uint rootCnt = *(uint *) bacbStack.top().getDataPtr();
+    bufMgr.unfixBlock(bacbStack.top());
+    bacbStack.pop();
+    if (rootCnt != 0)
+        throw DBIndexException("Predicate needs an empty index");
+
+    uint * text = (uint *) metaPtr+sizeof(BlockNo)+9;
+    if ((char *) (text + 1) + predicate.size() > metaPtr + DBFileBlock::getBlockSize())
+        throw DBIndexException("Predicate does not fit into the meta block");
+    *text = predicate.size();
+    memcpy(text + 1, predicate.data(), predicate.size());
+    *((uint *) metaPtr+sizeof(BlockNo)+7) = 1;
+    this->predicate = predicate;
+    partial = true;
+    countChange();
+}
+
+bool DBMyIndex::predicateImplied(const string &predicate) const {
+    return partial == false || this->predicate == predicate;
+}
+
+/**
+ * Zaehlt jede schreibende Operation im Metablock mit (Metablock oben auf dem
+ * bacbStack); ein Bloom-Filter mit anderem Stand ist veraltet. Die Marke fuer
+ * eine zurueckgeschriebene Datei wird geloescht und erst beim Schliessen
+ * dieses Handles wieder gesetzt.
+ */
+void DBMyIndex::countChange() {
+    uint * changes = (uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+6;
+    ++*changes;
+    *(changes+2) = 0;
+    bacbStack.top().setModified();
+    filterStamp = *changes;
+    changed = true;
+}
+
+/**
+ * Baut den Bloom-Filter aus allen Blaettern (und im buffered mode den
+ * Insert-Nachrichten der inneren Knoten) neu auf. Platz fuer doppelt so viele
+ * Schluessel, wie der Baum enthaelt; ist er erschoepft, wird erneut aufgebaut.
+ */
+void DBMyIndex::buildFilter() {
+    LOG4CXX_INFO(logger,"buildFilter()");
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const uint msgSize = entrySize + sizeof(char);
+    char * metaPtr = bacbStack.top().getDataPtr();
+    uint depth = *((uint *) metaPtr+sizeof(BlockNo));
+    vector<BlockNo> level(1, *(BlockNo *) metaPtr);
+    vector<pair<uint,uint> > hashes;
+    uint h1, h2;
+
+    for (uint d = 0; d < depth; d++) {
+        vector<BlockNo> next;
+        for (uint i = 0; i < level.size(); i++) {
+            DBBACB bacb = bufMgr.fixBlock(file, level[i], LOCK_SHARED);
+            const char * ptr = bacb.getDataPtr();
+            uint cnt = *(const uint *) ptr;
+            ptr += sizeof(uint);
+            for (uint k = 0; k <= cnt; k++) {
+                next.push_back(*(const BlockNo *) ptr);
+                ptr += sizeof(BlockNo) + attrTypeSize;
+            }
+            if (buffered) {
+                const char * msgs = bacb.getDataPtr() + innerBufferOffset();
+                uint msgCnt = *(const uint *) msgs;
+                msgs += sizeof(uint);
+                for (uint m = 0; m < msgCnt; m++, msgs += msgSize) {
+                    if (msgs[entrySize] != MSG_INSERT)
+                        continue;
+                    filterHashes(msgs, h1, h2);
+                    hashes.push_back(make_pair(h1, h2));
+                }
+            }
+            bufMgr.unfixBlock(bacb);
+        }
+        level.swap(next);
+    }
+
+    vector<char> image;
+    for (uint i = 0; i < level.size(); i++) {
+        DBBACB bacb = bufMgr.fixBlock(file, level[i], LOCK_SHARED);
+        const char * entries = bacb.getDataPtr();
+        if (leafFormat != LEAF_PLAIN) {
+            decodeLeaf(entries, image);
+            entries = &image[0];
+        }
+        uint cnt = *(const uint *) entries;
+        entries += sizeof(uint);
+        for (uint e = 0; e < cnt; e++) {
+            filterHashes(entries + entrySize * e, h1, h2);
+            hashes.push_back(make_pair(h1, h2));
+        }
+        bufMgr.unfixBlock(bacb);
+    }
+
+    filterKeys = hashes.size();
+    filterCapacity = max(filterKeys * 2, 1024u);
+    filterBits = filterCapacity * filterBitsPerKey;
+    filter.assign((filterBits + 7) / 8, 0);
+    for (uint i = 0; i < hashes.size(); i++)
+        filterAdd(hashes[i].first, hashes[i].second);
+    filterStamp = *((uint *) metaPtr+sizeof(BlockNo)+6);
+    LOG4CXX_DEBUG(logger,"Filter: "+TO_STR(filterKeys)+" keys, "+TO_STR(filterBits)+" bits");
+}
+
+/**
+ * Zwei Hashwerte (FNV-1a mit verschiedenen Startwerten), daraus werden per
+ * double hashing filterHashCnt Bitpositionen abgeleitet. 0.0 und -0.0 sind
+ * gleiche Schluessel und muessen gleich gehasht werden.
+ */
+void DBMyIndex::filterHashes(const char * key, uint & h1, uint & h2) const {
+    double zero = 0.0;
+    if (attrType == DOUBLE && compareKeys(key, (const char *) &zero) == 0)
+        key = (const char *) &zero;
+    h1 = 2166136261u;
+    h2 = 0x9747b28cu;
+    for (uint i = 0; i < attrTypeSize; ++i) {
+        h1 = (h1 ^ (unsigned char) key[i]) * 16777619u;
+        h2 = (h2 ^ (unsigned char) key[i]) * 16777619u;
+    }
+    h2 |= 1;
+}
+
+void DBMyIndex::filterAdd(uint h1, uint h2) {
+    for (uint i = 0; i < filterHashCnt; ++i) {
+        uint bit = (h1 + i * h2) % filterBits;
+        filter[bit / 8] |= 1 << (bit % 8);
+    }
+}
+
+bool DBMyIndex::filterMayContain(const char * key) const {
+    uint h1, h2;
+    filterHashes(key, h1, h2);
+    for (uint i = 0; i < filterHashCnt; ++i) {
+        uint bit = (h1 + i * h2) % filterBits;
+        if ((filter[bit / 8] & (1 << (bit % 8))) == 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * true, wenn key sicher nicht im Index ist. Baut den Filter bei Bedarf (noch
+ * keiner oder andere Handles haben seit dem Aufbau geschrieben) zuerst neu auf;
+ * Metablock oben auf dem bacbStack.
+ */
+bool DBMyIndex::filterExcludes(const char * key) {
+    if (filterBits == 0 || *((uint *) bacbStack.top().getDataPtr()+sizeof(BlockNo)+6) != filterStamp)
+        buildFilter();
+    return filterMayContain(key) == false;
+}
+
+/**
+ * shared mode: Filterpruefung unter dem Latch (ohne Filter immer false). Haben
+ * andere Handles seit dem Aufbau geschrieben (Aenderungszaehler im Metablock),
+ * wird der Filter unter dem exklusiven Latch neu aufgebaut.
+ */
+bool DBMyIndex::sharedFilterExcludes(const char * key) {
+    {
+        latchScope latch(*this, false);
+        if (filterBits == 0)
+            return false;
+        DBBACB meta = bufMgr.fixBlock(file, metaBlockNo, LOCK_SHARED);
+        bool current = *((uint *) meta.getDataPtr()+sizeof(BlockNo)+6) == filterStamp;
+        bufMgr.unfixBlock(meta);
+        if (current)
+            return filterMayContain(key) == false;
+    }
+    writeScope scope(*this);
+    return filterExcludes(key);
+}
+
+DBMyIndex::latchScope::latchScope(const DBMyIndex &index, bool exclusive) : index(index) {
+    if (index.shared == false)
+        return;
+    if (exclusive)
+        pthread_rwlock_wrlock(&index.latch);
+    else
+        pthread_rwlock_rdlock(&index.latch);
+}
+
+DBMyIndex::latchScope::~latchScope() {
+    if (index.shared)
+        pthread_rwlock_unlock(&index.latch);
+}
+
+DBMyIndex::writeScope::writeScope(DBMyIndex &index) : index(index), latch(index, true), metaPtr(NULL) {
+    if (index.shared == false)
+        return;
+    index.bacbStack.push(index.bufMgr.fixBlock(index.file, metaBlockNo, LOCK_EXCLUSIVE));
+    metaPtr = index.bacbStack.top().getDataPtr();
+}
+
+DBMyIndex::writeScope::~writeScope() {
+    if (metaPtr == NULL)
+        return;
+    index.sharedRoot = *(const BlockNo *) metaPtr;
+    index.sharedDepth = *((const uint *) metaPtr+sizeof(BlockNo));
+    //auch nach einer Exception ist danach kein Block mehr fixiert
+    while (index.bacbStack.empty() == false) {
+        try {
+            index.bufMgr.unfixBlock(index.bacbStack.top());
+        } catch (DBException & e) {
+        }
+        index.bacbStack.pop();
+    }
+}
+
+/**
+ * Die letzten Bytes jeder Blattseite tragen einen Versionsstempel, der bei jeder
+ * Aenderung und jeder Wiederverwendung der Seite erhoeht wird. Kodierte Blaetter
+ * und Kopien lassen ihn unberuehrt.
+ */
+uint DBMyIndex::leafVersionOffset() const {
+    return DBFileBlock::getBlockSize() - sizeof(uint);
+}
+
+void DBMyIndex::stampLeaf(char * page) const {
+    ++*(uint *) (page + leafVersionOffset());
+}
+
+/**
+ * Wurzel und Tiefe des aktuellen Stands: aus dem fixierten Metablock oder
+ * im shared mode aus dem zuletzt von einem Schreiber veroeffentlichten Stand
+ */
+void DBMyIndex::currentRoot(BlockNo &root, uint &depth) {
+    if (shared) {
+        latchScope latch(*this, false);
+        root = sharedRoot;
+        depth = sharedDepth;
+        return;
+    }
+    if (bacbStack.size() != 1)
+        throw DBIndexException("BACB Stack is invalid");
+    char * metaPtr = bacbStack.top().getDataPtr();
+    root = *(BlockNo *) metaPtr;
+    depth = *((uint *) metaPtr+sizeof(BlockNo));
+}
+
+/**
+ * Bereichssuche ueber Cursor. Ohne Geschwisterzeiger zwischen Blaettern steigt der
+ * Cursor fuer jedes Blatt mit dessen rechter Grenze (kleinster Schluessel des
+ * naechsten Teilbaums) erneut von der Wurzel ab; das funktioniert auch auf
+ * copy-on-write Snapshots. Cursor lesen ohne bacbStack und koennen von
+ * verschiedenen Threads parallel geleert werden, Aenderungen am Index waehrend
+ * des Scans sind nur ueber einen Snapshot konsistent.
+ */
+DBMyIndex::rangeCursor DBMyIndex::openRange(const DBAttrType &lo, const DBAttrType &hi) {
+    LOG4CXX_INFO(logger,"openRange()");
+    rangeCursor cursor;
+    currentRoot(cursor.root, cursor.depth);
+    cursor.snapshot = false;
+    cursor.lo.resize(attrTypeSize);
+    cursor.hi.resize(attrTypeSize);
+    lo.write(&cursor.lo[0]);
+    hi.write(&cursor.hi[0]);
+    startCursor(cursor);
+    return cursor;
+}
+
+/**
+ * Cursor auf [lo, hi] (inklusive) vor den ersten Eintrag setzen
+ */
+void DBMyIndex::startCursor(rangeCursor &cursor) const {
+    cursor.hiInclusive = true;
+    cursor.next = cursor.lo;
+    cursor.nextExclusive = false;
+    cursor.done = compareKeys(&cursor.lo[0], &cursor.hi[0]) > 0;
+    cursor.leaf = metaBlockNo;
+    cursor.version = 0;
+    cursor.releases = 0;
+    cursor.leafStartExclusive = false;
+    cursor.pos = 0;
+}
+
+/**
+ * VCHAR-Schluessel werden auf attrTypeSize aufgefuellt und bytweise verglichen.
+ * Alle Schluessel, die mit prefix beginnen, liegen daher unabhaengig vom
+ * Fuellzeichen in [prefix 0x00..0x00, prefix 0xFF..0xFF]; ein zu langer
+ * Praefix wird wie beim Schreiben abgeschnitten.
+ */
+DBMyIndex::rangeCursor DBMyIndex::openPrefix(const string &prefix) {
+    LOG4CXX_INFO(logger,"openPrefix()");
+    LOG4CXX_DEBUG(logger,"prefix: "+prefix);
+    if (attrType != VCHAR)
+        throw DBIndexException("Prefix search needs a VCHAR index");
+    rangeCursor cursor;
+    currentRoot(cursor.root, cursor.depth);
+    cursor.snapshot = false;
+    uint len = min((size_t) attrTypeSize, prefix.size());
+    cursor.lo.assign(attrTypeSize, (char) 0x00);
+    cursor.hi.assign(attrTypeSize, (char) 0xFF);
+    memcpy(&cursor.lo[0], prefix.data(), len);
+    memcpy(&cursor.hi[0], prefix.data(), len);
+    startCursor(cursor);
+    return cursor;
+}
+
+void DBMyIndex::findPrefix(const string &prefix, DBListTID &tids) {
+    tids.clear();
+    tidListSink sink(tids);
+    findPrefix(prefix, sink);
+}
+
+void DBMyIndex::findPrefix(const string &prefix, tidSink &sink) {
+    LOG4CXX_INFO(logger,"findPrefix()");
+    rangeCursor cursor = openPrefix(prefix);
+    TID tid;
+    while (nextInRange(cursor, tid)) {
+        if (sink.put(tid) == false) {
+            LOG4CXX_DEBUG(logger,"Stopped by sink");
+            break;
+        }
+    }
+}
+
+DBMyIndex::rangeCursor DBMyIndex::openRange(const DBAttrType &lo, const DBAttrType &hi, const snapshotInfo &snapshot) {
+    {
+        latchScope latch(*this, false);
+        if (pinned.find(snapshot.epoch) == pinned.end())
+            throw DBIndexException("Snapshot is not active");
+    }
+    rangeCursor cursor = openRange(lo, hi);
+    cursor.root = snapshot.root;
+    cursor.depth = snapshot.depth;
+    cursor.snapshot = true;
+    return cursor;
+}
+
+/**
+ * Teilt [lo, hi] anhand der Schluessel innerer Knoten in bis zu parts etwa
+ * gleich grosse Teilbereiche; es wird nur so tief gelesen, bis genug
+ * Trennschluessel im Bereich liegen
+ */
+vector<DBMyIndex::rangeCursor> DBMyIndex::splitRange(const DBAttrType &lo, const DBAttrType &hi, uint parts) {
+    LOG4CXX_INFO(logger,"splitRange()");
+    LOG4CXX_DEBUG(logger,"parts: "+TO_STR(parts));
+    rangeCursor whole = openRange(lo, hi);
+    vector<rangeCursor> cursors;
+    if (parts <= 1 || whole.done) {
+        cursors.push_back(whole);
+        return cursors;
+    }
+
+    latchScope latch(*this, false);
+    if (shared && whole.snapshot == false) {
+        whole.root = sharedRoot;
+        whole.depth = sharedDepth;
+    }
+    vector<BlockNo> level(1, whole.root);
+    vector<vector<char> > separators;
+    for (uint d = 0; d < whole.depth && separators.size() + 1 < parts; d++) {
+        vector<BlockNo> next;
+        separators.clear();
+        for (uint i = 0; i < level.size(); i++) {
+            DBBACB bacb = bufMgr.fixBlock(file, level[i], LOCK_SHARED);
+            const char * page = bacb.getDataPtr();
+            uint cnt = *(const uint *) page;
+            const char * keys = page + sizeof(uint) + sizeof(BlockNo);
+            const uint pairSize = attrTypeSize + sizeof(BlockNo);
+            //Kind k deckt [key k-1, key k) ab: Kinder from..to ueberlappen [lo, hi],
+            //die Schluessel dazwischen liegen in (lo, hi]
+            uint from = innerSearch(keys, cnt, &whole.lo[0], attrTypeSize);
+            uint to = innerSearch(keys, cnt, &whole.hi[0], attrTypeSize);
+            for (uint k = from; k <= to; k++) {
+                next.push_back(*(const BlockNo *) (keys - sizeof(BlockNo) + pairSize * k));
+                if (k < to)
+                    separators.push_back(vector<char>(keys + pairSize * k, keys + pairSize * k + attrTypeSize));
+            }
+            bufMgr.unfixBlock(bacb);
+        }
+        level.swap(next);
+    }
+    LOG4CXX_DEBUG(logger,"Separators in range: "+TO_STR(separators.size()));
+
+    uint pieces = min((size_t) parts, separators.size() + 1);
+    vector<char> from = whole.lo;
+    for (uint p = 1; p <= pieces; p++) {
+        rangeCursor cursor = whole;
+        cursor.lo = from;
+        cursor.next = from;
+        if (p < pieces) {
+            const vector<char> & to = separators[(size_t) p * (separators.size() + 1) / pieces - 1];
+            cursor.hi = to;
+            cursor.hiInclusive = false;
+            from = to;
+        }
+        cursors.push_back(cursor);
+    }
+    return cursors;
+}
+
+/**
+ * Liefert die naechste TID im Bereich des Cursors, false am Ende
+ */
+bool DBMyIndex::nextInRange(rangeCursor &cursor, TID &tid) const {
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    while (cursor.pos * entrySize >= cursor.entries.size()) {
+        if (cursor.done)
+            return false;
+        loadRangeLeaf(cursor);
+    }
+    memcpy(&tid, &cursor.entries[cursor.pos * entrySize + attrTypeSize], sizeof(TID));
+    cursor.pos++;
+    return true;
+}
+
+/**
+ * Fuellt bis zu maxTids TIDs in einen zusammenhaengenden Puffer des Aufrufers,
+ * liefert die Anzahl, 0 am Ende
+ */
+uint DBMyIndex::nextInRange(rangeCursor &cursor, TID *tids, uint maxTids) const {
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    uint filled = 0;
+    while (filled < maxTids) {
+        uint cnt = cursor.entries.size() / entrySize;
+        if (cursor.pos == cnt) {
+            if (cursor.done)
+                break;
+            loadRangeLeaf(cursor);
+            continue;
+        }
+        for (; cursor.pos < cnt && filled < maxTids; cursor.pos++)
+            memcpy(&tids[filled++], &cursor.entries[cursor.pos * entrySize + attrTypeSize], sizeof(TID));
+    }
+    return filled;
+}
+
+/**
+ * Vor dem Weiterlesen eines pausierten Cursors (z.B. naechste Ergebnisseite)
+ * aufzurufen. Ist das aktuelle Blatt unveraendert und seitdem keine Seite
+ * freigegeben worden, geht es mit einem einzigen Seitenzugriff an derselben
+ * Stelle weiter (true). Sonst wird ab dem zuletzt gelieferten Schluessel neu
+ * abgestiegen, ohne Snapshot von der aktuellen Wurzel.
+ * Im buffered mode koennen Nachrichten oberhalb des Blatts liegen, dort wird
+ * immer neu abgestiegen.
+ */
+bool DBMyIndex::resumeRange(rangeCursor &cursor) {
+    LOG4CXX_INFO(logger,"resumeRange()");
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    if (cursor.snapshot == false) {
+        //die Wurzel kann sich seit dem letzten Abstieg geaendert haben
+        currentRoot(cursor.root, cursor.depth);
+    }
+    if (cursor.leaf == metaBlockNo)
+        return true;
+    //seit dem Laden freigegebene Seiten tragen keinen neuen Stempel
+    if (buffered == false) {
+        latchScope latch(*this, false);
+        if (cursor.releases == releaseCount) {
+            DBBACB bacb = bufMgr.fixBlock(file, cursor.leaf, LOCK_SHARED);
+            uint version = *(const uint *) (bacb.getDataPtr() + leafVersionOffset());
+            bufMgr.unfixBlock(bacb);
+            if (version == cursor.version) {
+                LOG4CXX_DEBUG(logger,"Leaf "+TO_STR(cursor.leaf)+" unchanged");
+                return true;
+            }
+        }
+    }
+    LOG4CXX_DEBUG(logger,"Leaf "+TO_STR(cursor.leaf)+" changed, descending again");
+
+    if (cursor.pos > 0) {
+        const char * last = &cursor.entries[(cursor.pos - 1) * entrySize];
+        cursor.next.assign(last, last + attrTypeSize);
+        cursor.nextExclusive = true;
+    } else {
+        cursor.next = cursor.leafStart;
+        cursor.nextExclusive = cursor.leafStartExclusive;
+    }
+    int cmpHi = compareKeys(&cursor.next[0], &cursor.hi[0]);
+    cursor.done = cmpHi > 0 || (cmpHi == 0 && (cursor.hiInclusive == false || cursor.nextExclusive));
+    cursor.leaf = metaBlockNo;
+    cursor.entries.clear();
+    cursor.pos = 0;
+    return false;
+}
+
+/**
+ * Steigt mit cursor.next zum Blatt ab und uebernimmt dessen Eintraege im Bereich.
+ * Im buffered mode werden die Nachrichten der Vorgaenger fuer das Blatt
+ * eingerechnet, von unten (alt) nach oben (neu).
+ */
+void DBMyIndex::loadRangeLeaf(rangeCursor &cursor) const {
+    LOG4CXX_INFO(logger,"loadRangeLeaf()");
+    const uint entrySize = attrTypeSize + sizeof(TID);
+    const uint msgSize = attrTypeSize + sizeof(TID) + sizeof(char);
+
+    //shared mode: jeder Abstieg beginnt an der aktuell veroeffentlichten Wurzel
+    latchScope latch(*this, false);
+    if (shared && cursor.snapshot == false) {
+        cursor.root = sharedRoot;
+        cursor.depth = sharedDepth;
+    }
+    BlockNo b = cursor.root;
+    vector<char> lowFence, highFence;
+    vector<vector<char> > buffers;
+    for (uint d = 0; d < cursor.depth; d++) {
+        DBBACB bacb = bufMgr.fixBlock(file, b, LOCK_SHARED);
+        const char * page = bacb.getDataPtr();
+        uint cnt = *(const uint *) page;
+        uint k = innerSearch(page + sizeof(uint) + sizeof(BlockNo), cnt, &cursor.next[0], attrTypeSize);
+        const char * ptr = page + sizeof(uint) + (sizeof(BlockNo) + attrTypeSize) * k;
+        if (k > 0)
+            lowFence.assign(ptr - attrTypeSize, ptr);
+        if (k < cnt)
+            highFence.assign(ptr + sizeof(BlockNo), ptr + sizeof(BlockNo) + attrTypeSize);
+        b = *(const BlockNo *) ptr;
+        if (buffered) {
+            const char * msgs = page + innerBufferOffset();
+            buffers.push_back(vector<char>(msgs + sizeof(uint), msgs + sizeof(uint) + msgSize * *(const uint *) msgs));
+        }
+        bufMgr.unfixBlock(bacb);
+    }
+
+    DBBACB bacb = bufMgr.fixBlock(file, b, LOCK_SHARED);
+    cursor.leaf = b;
+    cursor.version = *(const uint *) (bacb.getDataPtr() + leafVersionOffset());
+    cursor.releases = releaseCount;
+    cursor.leafStart = cursor.next;
+    cursor.leafStartExclusive = cursor.nextExclusive;
+    vector<char> image;
+    if (leafFormat != LEAF_PLAIN) {
+        decodeLeaf(bacb.getDataPtr(), image);
+    } else {
+        const char * page = bacb.getDataPtr();
+        image.assign(page, page + sizeof(uint) + entrySize * *(const uint *) page);
+    }
+    bufMgr.unfixBlock(bacb);
+
+    //Eintraege im Bereich [next, hi]
+    uint cnt = *(uint *) &image[0];
+    const char * entries = &image[sizeof(uint)];
+    cursor.entries.clear();
+    cursor.pos = 0;
+    uint first = leafSearch(entries, cnt, &cursor.next[0], attrTypeSize);
+    if (cursor.nextExclusive && first < cnt && compareKeys(entries + entrySize * first, &cursor.next[0]) == 0)
+        first++;
+    for (uint i = first; i < cnt; i++) {
+        const char * entry = entries + entrySize * i;
+        int cmpHi = compareKeys(entry, &cursor.hi[0]);
+        if (cmpHi > 0 || (cmpHi == 0 && cursor.hiInclusive == false))
+            break;
+        cursor.entries.insert(cursor.entries.end(), entry, entry + entrySize);
+    }
+
+    for (int level = (int) buffers.size() - 1; level >= 0; level--) {
+        const vector<char> & msgs = buffers[level];
+        for (uint m = 0; m + msgSize <= msgs.size(); m += msgSize) {
+            const char * msg = &msgs[m];
+            int cmpNext = compareKeys(msg, &cursor.next[0]);
+            if (cmpNext < 0 || (cmpNext == 0 && cursor.nextExclusive))
+                continue;
+            int cmpHi = compareKeys(msg, &cursor.hi[0]);
+            if (cmpHi > 0 || (cmpHi == 0 && cursor.hiInclusive == false))
+                continue;
+            if (highFence.empty() == false && compareKeys(msg, &highFence[0]) >= 0)
+                continue;
+            //Position im sortierten Ergebnis, vorhandenen Eintrag ersetzen oder loeschen
+            uint n = cursor.entries.size() / entrySize;
+            uint pos = n == 0 ? 0 : leafSearch(&cursor.entries[0], n, msg, attrTypeSize);
+            bool exists = pos < n && compareKeys(&cursor.entries[pos * entrySize], msg) == 0;
+            vector<char>::iterator it = cursor.entries.begin() + pos * entrySize;
+            if (msg[attrTypeSize + sizeof(TID)] == MSG_INSERT) {
+                if (exists)
+                    memcpy(&*it + attrTypeSize, msg + attrTypeSize, sizeof(TID));
+                else
+                    cursor.entries.insert(it, msg, msg + entrySize);
+            } else if (exists) {
+                cursor.entries.erase(it, it + entrySize);
+            }
+        }
+    }
+
+    //naechstes Blatt beginnt mit der rechten Grenze
+    if (highFence.empty()) {
+        cursor.done = true;
+    } else {
+        int cmpHi = compareKeys(&highFence[0], &cursor.hi[0]);
+        cursor.done = cmpHi > 0 || (cmpHi == 0 && cursor.hiInclusive == false);
+        cursor.next = highFence;
+        cursor.nextExclusive = false;
+    }
+    LOG4CXX_DEBUG(logger,"Leaf "+TO_STR(b)+": "+TO_STR(cursor.entries.size() / entrySize)+" entries in range");
+}
+
+void DBMyIndex::findRange(const DBAttrType &lo, const DBAttrType &hi, DBListTID &tids) {
+    tids.clear();
+    tidListSink sink(tids);
+    findRange(lo, hi, sink);
+}
+
+/**
+ * Liefert die TIDs blattweise an den Verbraucher, ohne das Ergebnis vorher
+ * vollstaendig aufzubauen
+ */
+void DBMyIndex::findRange(const DBAttrType &lo, const DBAttrType &hi, tidSink &sink) {
+    LOG4CXX_INFO(logger,"findRange()");
+    rangeCursor cursor = openRange(lo, hi);
+    TID tid;
+    while (nextInRange(cursor, tid)) {
+        if (sink.put(tid) == false) {
+            LOG4CXX_DEBUG(logger,"Stopped by sink");
+            break;
+        }
+    }
+}
+
+void DBMyIndex::unfixBACBs(bool setDirty) {
+    LOG4CXX_INFO(logger,"unfixBACBs()");
+    LOG4CXX_DEBUG(logger,"setDirty: "+TO_STR(setDirty));
+    LOG4CXX_DEBUG(logger,"bacbStack.size()= "+TO_STR(bacbStack.size()));
+    //shared mode: zwischen den Aufrufen ist kein Block fixiert (siehe writeScope)
+    if (shared)
+        return;
+    while (bacbStack.empty() == false) {
+        try {
+            if (bacbStack.top().getModified()) {
+                if (setDirty == true)
+                    bacbStack.top().setDirty();
+            }
+            bufMgr.unfixBlock(bacbStack.top());
+        } catch (DBException & e) {
+        }
+        bacbStack.pop();
+    }
 }
 
 int DBMyIndex::registerClass() {
     setClassForName("DBMyIndex", createDBMyIndex);
+    setClassForName("DBMyBufferedIndex", createDBMyBufferedIndex);
+    setClassForName("DBMyCompressedIndex", createDBMyCompressedIndex);
+    setClassForName("DBMyPackedIndex", createDBMyPackedIndex);
+    setClassForName("DBMyMappedIndex", createDBMyMappedIndex);
+    setClassForName("DBMyCowIndex", createDBMyCowIndex);
+    setClassForName("DBMySharedIndex", createDBMySharedIndex);
+    setClassForName("DBMyFilteredIndex", createDBMyFilteredIndex);
+    setClassForName("DBMyResidentIndex", createDBMyResidentIndex);
     return 0;
 }
 
@@ -865,3 +4294,143 @@ extern "C" void * createDBMyIndex(int nArgs, va_list ap) {
     bool unique = (bool) va_arg(ap,int);
     return new DBMyIndex(*bufMgr, *file, attrType, m, unique);
 }
+
+/**
+ * Wie createDBMyIndex, legt neue Indexe aber mit Nachrichtenpuffern in den
+ * inneren Knoten an (buffered mode, siehe DBMyIndex::deliverMessage)
+ */
+extern "C" void * createDBMyBufferedIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBMyIndex(*bufMgr, *file, attrType, m, unique, true);
+}
+
+/**
+ * Wie createDBMyIndex, legt neue Indexe aber mit komprimierten Blaettern an
+ * (LEAF_FRONTCODED, siehe DBMyIndex::encodeLeaf)
+ */
+extern "C" void * createDBMyCompressedIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBMyIndex(*bufMgr, *file, attrType, m, unique, false, DBMyIndex::LEAF_FRONTCODED);
+}
+
+/**
+ * Wie createDBMyIndex, legt neue Indexe mit bitgepackten Blaettern an
+ * (LEAF_PACKED, siehe DBMyIndex::encodePackedLeaf); nur fuer INT, sonst praefixkodiert
+ */
+extern "C" void * createDBMyPackedIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBMyIndex(*bufMgr, *file, attrType, m, unique, false, DBMyIndex::LEAF_PACKED);
+}
+
+/**
+ * Wie createDBMyIndex; mit ModType READ geoeffnet wird die Indexdatei gemappt
+ * und find() umgeht den Buffermanager (siehe DBMyIndex::mapFile)
+ */
+extern "C" void * createDBMyMappedIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBMyIndex(*bufMgr, *file, attrType, m, unique, false, DBMyIndex::LEAF_PLAIN, true);
+}
+
+/**
+ * Wie createDBMyIndex, legt neue Indexe aber im copy-on-write mode an
+ * (siehe DBMyIndex::copyPath und DBMyIndex::beginSnapshot)
+ */
+extern "C" void * createDBMyCowIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBMyIndex(*bufMgr, *file, attrType, m, unique, false, DBMyIndex::LEAF_PLAIN, false, true);
+}
+
+/**
+ * Wie createDBMyIndex, das Handle kann aber von mehreren Threads gleichzeitig
+ * benutzt werden (siehe DBMyIndex::writeScope und DBMyIndex::loadRangeLeaf)
+ */
+extern "C" void * createDBMySharedIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBMyIndex(*bufMgr, *file, attrType, m, unique, false, DBMyIndex::LEAF_PLAIN, false, false, true);
+}
+
+/**
+ * Wie createDBMyIndex, mit Bloom-Filter ueber alle Schluessel, der beim
+ * Oeffnen aufgebaut wird (siehe DBMyIndex::buildFilter)
+ */
+extern "C" void * createDBMyFilteredIndex(int nArgs, va_list ap) {
+    // Genau 5 Parameter
+    if (nArgs != 5) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    return new DBMyIndex(*bufMgr, *file, attrType, m, unique, false, DBMyIndex::LEAF_PLAIN, false, false, false, true);
+}
+
+/**
+ * Wie createDBMyIndex, im READ mode wird die Datei aber am Page Cache vorbei
+ * in Huge Pages geladen (siehe DBMyIndex::loadFile); optionaler 6. Parameter
+ * ist die erlaubte Groesse in MB
+ */
+extern "C" void * createDBMyResidentIndex(int nArgs, va_list ap) {
+    // 5 oder 6 Parameter
+    if (nArgs != 5 && nArgs != 6) {
+        throw DBException("Invalid number of arguments");
+    }
+    DBBufferMgr * bufMgr = va_arg(ap,DBBufferMgr *);
+    DBFile * file = va_arg(ap,DBFile *);
+    enum AttrTypeEnum attrType = (enum AttrTypeEnum) va_arg(ap,int);
+    ModType m = (ModType) va_arg(ap,int);
+    bool unique = (bool) va_arg(ap,int);
+    size_t limitMB = 64;
+    if (nArgs == 6)
+        limitMB = va_arg(ap,uint);
+    return new DBMyIndex(*bufMgr, *file, attrType, m, unique, false, DBMyIndex::LEAF_PLAIN, true, false, false, false, limitMB * 1024 * 1024);
+}
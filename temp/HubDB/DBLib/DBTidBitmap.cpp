@@ -0,0 +1,304 @@
+#include <hubDB/DBTidBitmap.h>
+#include <hubDB/DBException.h>
+#include <algorithm>
+#include <iterator>
+
+using namespace HubDB::Index;
+using namespace HubDB::Exception;
+
+LoggerPtr DBTidBitmap::logger(Logger::getLogger("HubDB.Index.DBTidBitmap"));
+
+namespace {
+    inline uint bitCount(unsigned long long w) {
+        return __builtin_popcountll(w);
+    }
+
+    inline bool hasBit(const vector<unsigned long long> & words, uint slot) {
+        return slot / 64 < words.size() && (words[slot / 64] & (1ULL << (slot % 64))) != 0;
+    }
+
+    uint countBits(const vector<unsigned long long> & words) {
+        uint cnt = 0;
+        for (size_t i = 0; i < words.size(); i++)
+            cnt += bitCount(words[i]);
+        return cnt;
+    }
+}
+
+DBTidBitmap::DBTidBitmap() : cnt(0) {
+}
+
+string DBTidBitmap::toString(string linePrefix) const {
+    return linePrefix + "DBTidBitmap pages: " + TO_STR(pages.size()) + ", tids: " + TO_STR(cnt);
+}
+
+void DBTidBitmap::clear() {
+    pages.clear();
+    cnt = 0;
+}
+
+void DBTidBitmap::add(const TID &tid) {
+    slotSet & set = pages[tid.page];
+    if (set.words.empty() == false) {
+        if (tid.slot / 64 >= set.words.size())
+            set.words.resize(tid.slot / 64 + 1, 0);
+        word bit = 1ULL << (tid.slot % 64);
+        if ((set.words[tid.slot / 64] & bit) != 0)
+            return;
+        set.words[tid.slot / 64] |= bit;
+    } else {
+        vector<uint>::iterator it = lower_bound(set.slots.begin(), set.slots.end(), tid.slot);
+        if (it != set.slots.end() && *it == tid.slot)
+            return;
+        set.slots.insert(it, tid.slot);
+    }
+    set.cnt++;
+    cnt++;
+    optimize(set);
+}
+
+bool DBTidBitmap::contains(const TID &tid) const {
+    pageMap::const_iterator it = pages.find(tid.page);
+    if (it == pages.end())
+        return false;
+    if (it->second.words.empty() == false)
+        return hasBit(it->second.words, tid.slot);
+    return binary_search(it->second.slots.begin(), it->second.slots.end(), tid.slot);
+}
+
+/**
+ * Schnittmenge: Seiten, die nur in einer der beiden Bitmaps vorkommen, fallen
+ * ohne Blick auf die Slots weg
+ */
+void DBTidBitmap::andWith(const DBTidBitmap &other) {
+    LOG4CXX_INFO(logger,"andWith()");
+    pageMap::iterator it = pages.begin();
+    pageMap::const_iterator ot = other.pages.begin();
+    cnt = 0;
+    while (it != pages.end()) {
+        while (ot != other.pages.end() && ot->first < it->first)
+            ++ot;
+        if (ot == other.pages.end() || it->first < ot->first) {
+            pages.erase(it++);
+            continue;
+        }
+        andSets(it->second, ot->second);
+        cnt += it->second.cnt;
+        if (it->second.cnt == 0)
+            pages.erase(it++);
+        else
+            ++it;
+    }
+    LOG4CXX_DEBUG(logger,toString());
+}
+
+void DBTidBitmap::orWith(const DBTidBitmap &other) {
+    LOG4CXX_INFO(logger,"orWith()");
+    for (pageMap::const_iterator ot = other.pages.begin(); ot != other.pages.end(); ++ot) {
+        pageMap::iterator it = pages.lower_bound(ot->first);
+        if (it == pages.end() || it->first != ot->first) {
+            pages.insert(it, *ot);
+            cnt += ot->second.cnt;
+        } else {
+            cnt -= it->second.cnt;
+            orSets(it->second, ot->second);
+            cnt += it->second.cnt;
+        }
+    }
+    LOG4CXX_DEBUG(logger,toString());
+}
+
+void DBTidBitmap::andNotWith(const DBTidBitmap &other) {
+    LOG4CXX_INFO(logger,"andNotWith()");
+    pageMap::iterator it = pages.begin();
+    pageMap::const_iterator ot = other.pages.begin();
+    while (it != pages.end() && ot != other.pages.end()) {
+        if (ot->first < it->first) {
+            ++ot;
+        } else if (it->first < ot->first) {
+            ++it;
+        } else {
+            cnt -= it->second.cnt;
+            andNotSets(it->second, ot->second);
+            cnt += it->second.cnt;
+            if (it->second.cnt == 0)
+                pages.erase(it++);
+            else
+                ++it;
+            ++ot;
+        }
+    }
+    LOG4CXX_DEBUG(logger,toString());
+}
+
+/**
+ * Liefert die Slots jeder Seite aufsteigend, die Seiten in aufsteigender
+ * BlockNo-Reihenfolge
+ */
+void DBTidBitmap::forEachPage(pageVisitor &visitor) const {
+    vector<uint> slots;
+    for (pageMap::const_iterator it = pages.begin(); it != pages.end(); ++it) {
+        const slotSet & set = it->second;
+        bool more;
+        if (set.words.empty()) {
+            more = visitor.visit(it->first, &set.slots[0], set.cnt);
+        } else {
+            slotsOf(set, slots);
+            more = visitor.visit(it->first, &slots[0], set.cnt);
+        }
+        if (more == false)
+            break;
+    }
+}
+
+void DBTidBitmap::toList(DBListTID &tids) const {
+    tids.clear();
+    vector<uint> slots;
+    for (pageMap::const_iterator it = pages.begin(); it != pages.end(); ++it) {
+        slotsOf(it->second, slots);
+        for (uint i = 0; i < slots.size(); i++)
+            tids.push_back(TID(it->first, slots[i]));
+    }
+}
+
+void DBTidBitmap::slotsOf(const slotSet &set, vector<uint> &slots) {
+    if (set.words.empty()) {
+        slots = set.slots;
+        return;
+    }
+    slots.clear();
+    for (size_t i = 0; i < set.words.size(); i++) {
+        word w = set.words[i];
+        while (w != 0) {
+            slots.push_back(i * 64 + __builtin_ctzll(w));
+            w &= w - 1;
+        }
+    }
+}
+
+void DBTidBitmap::toBitmap(slotSet &set) {
+    if (set.words.empty() == false || set.slots.empty())
+        return;
+    set.words.assign(set.slots.back() / 64 + 1, 0);
+    for (size_t i = 0; i < set.slots.size(); i++)
+        set.words[set.slots[i] / 64] |= 1ULL << (set.slots[i] % 64);
+    vector<uint>().swap(set.slots);
+}
+
+void DBTidBitmap::toArray(slotSet &set) {
+    if (set.words.empty())
+        return;
+    slotsOf(set, set.slots);
+    vector<word>().swap(set.words);
+}
+
+/**
+ * Waehlt die kleinere Darstellung: ein Array braucht 4 Byte je Slot, eine
+ * Bitmap 8 Byte je 64 Slots bis zum groessten Slot
+ */
+void DBTidBitmap::optimize(slotSet &set) {
+    if (set.words.empty() == false) {
+        while (set.words.empty() == false && set.words.back() == 0)
+            set.words.pop_back();
+        if (set.cnt * sizeof(uint) < set.words.size() * sizeof(word))
+            toArray(set);
+    } else if (set.slots.empty() == false) {
+        if ((set.slots.back() / 64 + 1) * sizeof(word) < set.slots.size() * sizeof(uint))
+            toBitmap(set);
+    }
+}
+
+void DBTidBitmap::andSets(slotSet &set, const slotSet &other) {
+    if (set.words.empty() == false && other.words.empty() == false) {
+        size_t n = min(set.words.size(), other.words.size());
+        set.words.resize(n);
+        for (size_t i = 0; i < n; i++)
+            set.words[i] &= other.words[i];
+        set.cnt = countBits(set.words);
+    } else if (set.words.empty() == false) {
+        //Ergebnis ist hoechstens so gross wie das Array der anderen Seite
+        vector<uint> slots;
+        for (size_t i = 0; i < other.slots.size(); i++)
+            if (hasBit(set.words, other.slots[i]))
+                slots.push_back(other.slots[i]);
+        vector<word>().swap(set.words);
+        set.slots.swap(slots);
+        set.cnt = set.slots.size();
+    } else if (other.words.empty() == false) {
+        size_t kept = 0;
+        for (size_t i = 0; i < set.slots.size(); i++)
+            if (hasBit(other.words, set.slots[i]))
+                set.slots[kept++] = set.slots[i];
+        set.slots.resize(kept);
+        set.cnt = kept;
+    } else {
+        //beide sortiert: mischen, Ergebnis in place
+        size_t kept = 0, j = 0;
+        for (size_t i = 0; i < set.slots.size() && j < other.slots.size(); i++) {
+            while (j < other.slots.size() && other.slots[j] < set.slots[i])
+                j++;
+            if (j < other.slots.size() && other.slots[j] == set.slots[i])
+                set.slots[kept++] = set.slots[i];
+        }
+        set.slots.resize(kept);
+        set.cnt = kept;
+    }
+    optimize(set);
+}
+
+void DBTidBitmap::orSets(slotSet &set, const slotSet &other) {
+    if (set.words.empty() && other.words.empty()) {
+        vector<uint> slots;
+        slots.reserve(set.slots.size() + other.slots.size());
+        set_union(set.slots.begin(), set.slots.end(), other.slots.begin(), other.slots.end(), back_inserter(slots));
+        set.slots.swap(slots);
+        set.cnt = set.slots.size();
+    } else {
+        toBitmap(set);
+        if (other.words.empty() == false) {
+            if (set.words.size() < other.words.size())
+                set.words.resize(other.words.size(), 0);
+            for (size_t i = 0; i < other.words.size(); i++)
+                set.words[i] |= other.words[i];
+        } else {
+            if (set.words.size() < other.slots.back() / 64 + 1)
+                set.words.resize(other.slots.back() / 64 + 1, 0);
+            for (size_t i = 0; i < other.slots.size(); i++)
+                set.words[other.slots[i] / 64] |= 1ULL << (other.slots[i] % 64);
+        }
+        set.cnt = countBits(set.words);
+    }
+    optimize(set);
+}
+
+void DBTidBitmap::andNotSets(slotSet &set, const slotSet &other) {
+    if (set.words.empty() == false && other.words.empty() == false) {
+        size_t n = min(set.words.size(), other.words.size());
+        for (size_t i = 0; i < n; i++)
+            set.words[i] &= ~other.words[i];
+        set.cnt = countBits(set.words);
+    } else if (set.words.empty() == false) {
+        for (size_t i = 0; i < other.slots.size(); i++)
+            if (other.slots[i] / 64 < set.words.size())
+                set.words[other.slots[i] / 64] &= ~(1ULL << (other.slots[i] % 64));
+        set.cnt = countBits(set.words);
+    } else if (other.words.empty() == false) {
+        size_t kept = 0;
+        for (size_t i = 0; i < set.slots.size(); i++)
+            if (hasBit(other.words, set.slots[i]) == false)
+                set.slots[kept++] = set.slots[i];
+        set.slots.resize(kept);
+        set.cnt = kept;
+    } else {
+        size_t kept = 0, j = 0;
+        for (size_t i = 0; i < set.slots.size(); i++) {
+            while (j < other.slots.size() && other.slots[j] < set.slots[i])
+                j++;
+            if (j == other.slots.size() || other.slots[j] != set.slots[i])
+                set.slots[kept++] = set.slots[i];
+        }
+        set.slots.resize(kept);
+        set.cnt = kept;
+    }
+    optimize(set);
+}
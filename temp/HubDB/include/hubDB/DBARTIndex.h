@@ -0,0 +1,100 @@
+
+#ifndef HUBDB_DBARTINDEX_H
+#define HUBDB_DBARTINDEX_H
+
+#include <hubDB/DBIndex.h>
+
+namespace HubDB{
+    namespace Index{
+        /**
+         * Hauptspeicherresidenter Index als Adaptive Radix Tree (Node4/16/48/256)
+         * - Schluessel werden binaer vergleichbar normalisiert (feste Laenge attrTypeSize)
+         * - find/insert/remove ohne Seitenzugriffe ueber den Buffermanager
+         * - Datei haelt einen Snapshot und dahinter ein Log der Aenderungen seit dem Snapshot:
+         *   beim Oeffnen laden und Log nachspielen, bei zu langem Log und beim Schliessen neuer Snapshot
+         */
+        class DBARTIndex : public DBIndex{
+
+        public:
+            DBARTIndex(DBBufferMgr & bufferMgr,DBFile & file,enum AttrTypeEnum attrType,ModType mode,bool unique);
+            ~DBARTIndex();
+            string toString(string linePrefix="") const;
+
+            void initializeIndex();
+            void find(const DBAttrType & val,DBListTID & tids);
+            void findRange(const DBAttrType & lo,const DBAttrType & hi,DBListTID & tids);
+            void insert(const DBAttrType & val,const TID & tid);
+            void remove(const DBAttrType & val,const DBListTID & tid);
+            bool isIndexNonUniqueAble(){ return false;};
+            void unfixBACBs(bool dirty);
+            void snapshot();
+
+            static int registerClass();
+
+        private:
+            enum nodeType { NODE4, NODE16, NODE48, NODE256 };
+            static const uint maxPrefixLen = 8;
+
+            struct artNode {
+                unsigned char type;
+                uint numChildren;
+                uint prefixLen;
+                unsigned char prefix[maxPrefixLen];
+            };
+            struct artNode4 : artNode {
+                unsigned char keys[4];
+                artNode * children[4];
+            };
+            struct artNode16 : artNode {
+                unsigned char keys[16];
+                artNode * children[16];
+            };
+            struct artNode48 : artNode {
+                unsigned char childIndex[256];
+                artNode * children[48];
+            };
+            struct artNode256 : artNode {
+                artNode * children[256];
+            };
+            struct artLeaf {
+                TID tid;
+                unsigned char key[1];
+            };
+
+            void normalizeKey(const DBAttrType & val,unsigned char * key)const;
+
+            artLeaf * makeLeaf(const unsigned char * key,const TID & tid);
+            artLeaf * minimum(artNode * n)const;
+            artLeaf * maximum(artNode * n)const;
+            artNode ** findChild(artNode * n,unsigned char c)const;
+            uint checkPrefix(const artNode * n,const unsigned char * key,uint depth)const;
+            uint prefixMismatch(artNode * n,const unsigned char * key,uint depth)const;
+
+            void addChild(artNode * n,artNode ** ref,unsigned char c,artNode * child);
+            void removeChild(artNode * n,artNode ** ref,unsigned char c,artNode ** child);
+            bool insertRec(artNode * n,artNode ** ref,const unsigned char * key,uint depth,const TID & tid);
+            artLeaf * removeRec(artNode * n,artNode ** ref,const unsigned char * key,uint depth);
+            uint orderedChildren(artNode * n,unsigned char * keys,artNode ** children)const;
+            void rangeRec(artNode * n,uint depth,bool onLowerPath,const unsigned char * lo,const unsigned char * hi,DBListTID & tids,bool & done)const;
+            void collectLeaves(artNode * n,vector<artLeaf *> & leaves)const;
+            void destroyRec(artNode * n);
+            void load();
+            uint entriesPerPage()const;
+            uint entriesPerLogPage()const;
+            BlockNo logStart();
+            void appendToLog(const unsigned char * key,const TID & tid,bool tombstone);
+            void replayLog();
+
+            static LoggerPtr logger;
+            static const BlockNo metaBlockNo;
+            stack<DBBACB> bacbStack;
+            artNode * root;
+            uint keyLen;
+            uint entryCnt;
+            bool modified;
+            uint logTailCnt;
+        };
+    }
+}
+
+#endif //HUBDB_DBARTINDEX_H
@@ -0,0 +1,62 @@
+
+#ifndef HUBDB_DBHASHINDEX_H
+#define HUBDB_DBHASHINDEX_H
+
+#include <hubDB/DBIndex.h>
+
+namespace HubDB{
+    namespace Index{
+        /**
+         * Erweiterbares Hashing (extendible hashing)
+         * - Metablock: globale Tiefe + Verzeichnis der Bucket-BlockNos
+         * - Bucket: Anzahl, lokale Tiefe, Overflow-BlockNo, Eintraege (key, TID)
+         * Punktanfragen: ein Verzeichniszugriff (Metablock ist dauerhaft gefixt) + ein Bucket-Fix
+         * - leere Buckets werden mit ihrem Buddy verschmolzen, freie Seiten kommen in eine Freiliste
+         */
+        class DBHashIndex : public DBIndex{
+
+        public:
+            DBHashIndex(DBBufferMgr & bufferMgr,DBFile & file,enum AttrTypeEnum attrType,ModType mode,bool unique);
+            ~DBHashIndex();
+            string toString(string linePrefix="") const;
+
+            void initializeIndex();
+            void find(const DBAttrType & val,DBListTID & tids);
+            void insert(const DBAttrType & val,const TID & tid);
+            void remove(const DBAttrType & val,const DBListTID & tid);
+            bool isIndexNonUniqueAble(){ return true;};
+            void unfixBACBs(bool dirty);
+
+            static int registerClass();
+
+        private:
+            uint entriesPerBucket()const;
+            uint maxGlobalDepth()const;
+            const char * keyBytes(const DBAttrType & val)const;
+            uint hashBytes(const char * key)const;
+
+            uint * globalDepthPtr();
+            BlockNo * directoryPtr();
+            BlockNo * freeHeadPtr();
+
+            void findInBucket(const char * key,BlockNo b,DBListTID & tids);
+            bool appendToBucket(BlockNo b,const char * entry,bool allowOverflow);
+            bool bucketHoldsOnlyHash(BlockNo b,uint h);
+            void splitBucket(uint dirIdx);
+            void doubleDirectory();
+            void mergeEmptyBucket(uint dirIdx);
+            void shrinkDirectory();
+            DBBACB fixFreeBlock();
+            void releaseBlock(BlockNo b);
+
+            static LoggerPtr logger;
+            static const BlockNo metaBlockNo;
+            static const BlockNo noOverflow;
+            stack<DBBACB> bacbStack;
+            // Puffer fuer einen serialisierten Eintrag (key, TID), vermeidet new[] pro Aufruf
+            char * keyBuf;
+        };
+    }
+}
+
+#endif //HUBDB_DBHASHINDEX_H
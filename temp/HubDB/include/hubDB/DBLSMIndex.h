@@ -0,0 +1,126 @@
+
+#ifndef HUBDB_DBLSMINDEX_H
+#define HUBDB_DBLSMINDEX_H
+
+#include <hubDB/DBIndex.h>
+
+namespace HubDB{
+    namespace Index{
+        /**
+         * Log-Structured Merge Tree
+         * - Memtable im Hauptspeicher nimmt Inserts und Deletes (Tombstones) auf,
+         *   jede Aenderung wird vorher an ein Log in den Seiten der Datei angehaengt
+         *   und beim Oeffnen nachgespielt
+         * - volle Memtable wird als unveraenderlicher, sortierter Run in Seiten geschrieben
+         * - pro Run: duenner Fence-Index (erster Schluessel jeder Datenseite) und Bloom-Filter,
+         *   beide werden beim Oeffnen in den Hauptspeicher geladen
+         * - Level 0 gestaffelt (mehrere Runs), ab Level 1 ein Run pro Level
+         */
+        class DBLSMIndex : public DBIndex{
+
+        public:
+            DBLSMIndex(DBBufferMgr & bufferMgr,DBFile & file,enum AttrTypeEnum attrType,ModType mode,bool unique);
+            ~DBLSMIndex();
+            string toString(string linePrefix="") const;
+
+            void initializeIndex();
+            void find(const DBAttrType & val,DBListTID & tids);
+            void insert(const DBAttrType & val,const TID & tid);
+            void remove(const DBAttrType & val,const DBListTID & tid);
+            bool isIndexNonUniqueAble(){ return false;};
+            void unfixBACBs(bool dirty);
+
+            static int registerClass();
+
+        private:
+            struct keyLess {
+                bool operator()(const DBAttrType * a, const DBAttrType * b) const { return *a < *b; }
+            };
+            struct memEntry {
+                TID tid;
+                bool tombstone;
+            };
+            typedef map<DBAttrType *,memEntry,keyLess> memTable;
+
+            struct runInfo {
+                uint level;
+                uint entryCnt;
+                BlockNo fenceBlock;
+                BlockNo bloomBlock;
+                uint bloomBits;
+                vector<char> fenceKeys; //erster Schluessel je Datenseite, serialisiert
+                vector<BlockNo> fencePages;
+                vector<unsigned char> bloom;
+            };
+            struct runCursor {
+                const runInfo * run;
+                uint pageIdx;
+                uint slot;
+                uint cnt;
+                vector<char> page;
+                const char * key; //zeigt in page, NULL am Ende
+            };
+
+            uint entriesPerDataPage()const;
+            uint fencesPerPage()const;
+            uint entriesPerLogPage()const;
+            uint maxRuns()const;
+            uint memTableLimit()const;
+            uint levelCapacity(uint level)const;
+
+            void readMeta();
+            void writeMeta();
+            void loadRun(runInfo & run);
+            void dropRun(runInfo & run);
+
+            BlockNo allocPage();
+            void freePage(BlockNo b);
+            void loadPage(BlockNo b,vector<char> & page);
+            BlockNo writePage(const vector<char> & page);
+
+            void normalizeKey(const DBAttrType & val,char * buf)const;
+            int compareKeys(const char * a,const char * b)const;
+            void bloomHashes(const char * key,uint & h1,uint & h2)const;
+            bool bloomMayContain(const runInfo & run,const char * key)const;
+
+            bool findInMemTable(const DBAttrType & val,memEntry & result);
+            bool findInRun(const runInfo & run,const char * key,memEntry & result);
+            bool lookup(const DBAttrType & val,memEntry & result);
+            void putMemTable(const char * key,const TID & tid,bool tombstone);
+            void clearMemTable();
+
+            void appendToLog(const char * key,const TID & tid,bool tombstone);
+            void replayLog();
+            void dropLog();
+
+            void beginRun(runInfo & run,uint level,uint expectedEntries);
+            void appendToRun(runInfo & run,vector<char> & page,const char * key,const TID & tid,bool tombstone);
+            void finishRun(runInfo & run,vector<char> & page);
+
+            void openCursor(runCursor & cursor,const runInfo & run);
+            void advanceCursor(runCursor & cursor);
+
+            void flushMemTable();
+            void compact();
+            void mergeLevel(uint level);
+
+            static LoggerPtr logger;
+            static const BlockNo metaBlockNo;
+            static const BlockNo noBlock;
+            static const uint maxLevel0Runs;
+            static const uint memTablePages;
+            static const uint levelSizeRatio;
+            static const uint bloomBitsPerKey;
+            static const uint bloomHashCnt;
+            stack<DBBACB> bacbStack;
+            memTable mem;
+            vector<runInfo> runs;
+            BlockNo logTail;
+            uint logEntries;
+            // Puffer fuer einen serialisierten Schluessel, vermeidet new[] pro Aufruf
+            char * keyBuf;
+        };
+    }
+}
+
+#endif //HUBDB_DBLSMINDEX_H
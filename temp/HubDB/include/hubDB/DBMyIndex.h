@@ -3,20 +3,116 @@
 #define HUBDB_DBMYINDEX_H
 
 #include <hubDB/DBIndex.h>
+#include <hubDB/DBTidBitmap.h>
+#include <pthread.h>
+#include <set>
 
 namespace HubDB{
     namespace Index{
         class DBMyIndex : public DBIndex{
 
         public:
-            DBMyIndex(DBBufferMgr & bufferMgr,DBFile & file,enum AttrTypeEnum attrType,ModType mode,bool unique);
+            //Format der Blaetter: unkomprimiert, praefixkodiert oder (nur INT) bitgepackt
+            enum LeafFormat { LEAF_PLAIN, LEAF_FRONTCODED, LEAF_PACKED };
+
+            //Ergebnisausgabe ohne DBListTID: put() je TID, false bricht die Suche ab
+            class tidSink {
+            public:
+                virtual ~tidSink(){};
+                virtual bool put(const TID & tid) = 0;
+            };
+            class tidListSink : public tidSink {
+            public:
+                tidListSink(DBListTID & tids):tids(tids){};
+                bool put(const TID & tid){ tids.push_back(tid); return true;};
+            private:
+                DBListTID & tids;
+            };
+            //sammelt die TIDs in einer Bitmap, z.B. fuer AND/OR ueber mehrere Indexe
+            class tidBitmapSink : public tidSink {
+            public:
+                tidBitmapSink(DBTidBitmap & bitmap):bitmap(bitmap){};
+                bool put(const TID & tid){ bitmap.add(tid); return true;};
+            private:
+                DBTidBitmap & bitmap;
+            };
+
+            //shared: ein Handle fuer mehrere Threads, der Metablock bleibt nicht dauerhaft fixiert
+            //filtered: Bloom-Filter ueber alle Schluessel beantwortet die meisten erfolglosen Suchen
+            //residentLimit (mit mapped): Datei bis zu dieser Groesse in Bytes am Page Cache vorbei in Huge Pages laden
+            DBMyIndex(DBBufferMgr & bufferMgr,DBFile & file,enum AttrTypeEnum attrType,ModType mode,bool unique,bool buffered=false,enum LeafFormat leafFormat=LEAF_PLAIN,bool mapped=false,bool copyOnWrite=false,bool shared=false,bool filtered=false,size_t residentLimit=0);
             ~DBMyIndex();
             string toString(string linePrefix="") const;
 
             void initializeIndex();
             void find(const DBAttrType & val,DBListTID & tids);
+            void find(const DBAttrType & val,tidSink & sink);
+
+            //Lesen auf einem festen Stand des Baums (copy-on-write mode)
+            struct snapshotInfo {
+                BlockNo root;
+                uint depth;
+                uint epoch;
+            };
+            snapshotInfo beginSnapshot();
+            void find(const DBAttrType & val,DBListTID & tids,const snapshotInfo & snapshot);
+            void endSnapshot(const snapshotInfo & snapshot);
+
+            //Bereichssuche, Cursor verschiedener Threads koennen parallel gelesen werden
+            struct rangeCursor {
+                BlockNo root;
+                uint depth;
+                bool snapshot;
+                vector<char> lo;
+                vector<char> hi;
+                bool hiInclusive;
+                vector<char> next;
+                bool nextExclusive;
+                bool done;
+                //aktuelles Blatt mit Versionsstempel, zum Fortsetzen ohne Abstieg
+                BlockNo leaf;
+                uint version;
+                uint releases; //Stand von releaseCount beim Laden des Blatts
+                vector<char> leafStart;
+                bool leafStartExclusive;
+                vector<char> entries;
+                uint pos;
+            };
+            rangeCursor openRange(const DBAttrType & lo,const DBAttrType & hi);
+            rangeCursor openRange(const DBAttrType & lo,const DBAttrType & hi,const snapshotInfo & snapshot);
+            vector<rangeCursor> splitRange(const DBAttrType & lo,const DBAttrType & hi,uint parts);
+            bool nextInRange(rangeCursor & cursor,TID & tid)const;
+            uint nextInRange(rangeCursor & cursor,TID * tids,uint maxTids)const;
+            bool resumeRange(rangeCursor & cursor);
+            void findRange(const DBAttrType & lo,const DBAttrType & hi,DBListTID & tids);
+            void findRange(const DBAttrType & lo,const DBAttrType & hi,tidSink & sink);
+            //Praefixsuche auf VCHAR (LIKE 'abc%'), Schluessel werden bytweise verglichen
+            rangeCursor openPrefix(const string & prefix);
+            void findPrefix(const string & prefix,DBListTID & tids);
+            void findPrefix(const string & prefix,tidSink & sink);
             void insert(const DBAttrType & val,const TID & tid);
             void remove(const DBAttrType & val,const DBListTID & tid);
+            //partieller Index: qualifies ist das Praedikat, vom Aufrufer auf dem (alten) Tupel ausgewertet
+            void insert(const DBAttrType & val,const TID & tid,bool qualifies);
+            void remove(const DBAttrType & val,const DBListTID & tid,bool qualifies);
+            //loescht alle Eintraege mit Schluessel in [lo, hi], liefert die Anzahl freigegebener Seiten
+            uint removeRange(const DBAttrType & lo,const DBAttrType & hi);
+            void bulkLoad(const vector<const DBAttrType *> & keys,const vector<TID> & tids,uint threadCnt);
+            void bulkLoad(const vector<const DBAttrType *> & keys,const vector<TID> & tids,const vector<bool> & qualifies,uint threadCnt);
+            //Online-Aufbau: insert/remove laufen bis endOnlineBuild() in ein Nebenprotokoll,
+            //dazwischen wird der Tabellenscan per bulkLoad() geladen
+            void beginOnlineBuild();
+            void endOnlineBuild();
+            bool isBuilding()const{ return __atomic_load_n(&building, __ATOMIC_ACQUIRE);};
+            //partieller Index: nur qualifizierende Tupel werden indexiert, nur auf leerem Index;
+            //danach sind nur noch die Schreiboperationen mit qualifies erlaubt
+            void definePredicate(const string & predicate);
+            bool isPartial()const{ return partial;};
+            const string & getPredicate()const{ return predicate;};
+            //true, wenn die Anfrage das Praedikat des Index enthaelt (gleiche Normalform, fuer den Planer)
+            bool predicateImplied(const string & predicate)const;
+            //legt die Blaetter in Schluesselreihenfolge auf aufsteigende Seiten, liefert die Anzahl verschobener Blaetter
+            uint defragment();
             bool isIndexNonUniqueAble(){ return false;};
             void unfixBACBs(bool dirty);
 
@@ -26,26 +122,222 @@ namespace HubDB{
             struct splitInfo {
                 //splitInfo();
                 bool splitHappens;
-                const DBAttrType * newKey;
+                const char * newKey; //serialisiert, im opArena
                 BlockNo newBlockNo;
             };
+            //Zwischenspeicher einer Operation (Such- und Splitschluessel), wird am Ende
+            //von find/insert/remove zurueckgesetzt, die Speicherbloecke bleiben erhalten
+            class opArena {
+            public:
+                struct mark {
+                    uint chunk;
+                    uint used;
+                };
+                opArena():chunk(0),used(0){};
+                ~opArena();
+                char * alloc(uint size);
+                mark getMark()const{ mark m; m.chunk = chunk; m.used = used; return m;};
+                void release(const mark & m){ chunk = m.chunk; used = m.used;};
+            private:
+                opArena(const opArena &);
+                vector<char *> chunks;
+                vector<uint> sizes;
+                uint chunk;
+                uint used;
+            };
+            class arenaScope {
+            public:
+                arenaScope(opArena & arena):arena(arena),start(arena.getMark()){};
+                ~arenaScope(){ arena.release(start);};
+            private:
+                opArena & arena;
+                opArena::mark start;
+            };
+            //Pfad von der Wurzel zum Blatt ohne Heapspeicher
+            static const uint maxDepth = 32;
+            class pathStack {
+            public:
+                pathStack():cnt(0){};
+                void push(BlockNo b);
+                BlockNo top()const{ return blocks[cnt-1];};
+                void pop(){ --cnt;};
+                bool empty()const{ return cnt == 0;};
+            private:
+                BlockNo blocks[maxDepth + 1];
+                uint cnt;
+            };
+            //shared mode: Leser teilen, Schreiber halten den Latch des Handles exklusiv
+            class latchScope {
+            public:
+                latchScope(const DBMyIndex & index, bool exclusive);
+                ~latchScope();
+            private:
+                const DBMyIndex & index;
+            };
+            //shared mode: Schreiber fixieren den Metablock nur fuer die Dauer des Aufrufs
+            //und veroeffentlichen danach Wurzel und Tiefe fuer die Leser
+            class writeScope {
+            public:
+                writeScope(DBMyIndex & index);
+                ~writeScope();
+            private:
+                DBMyIndex & index;
+                latchScope latch;
+                const char * metaPtr;
+            };
+            //Nachrichten im Puffer der inneren Knoten (buffered mode)
+            enum msgOp { MSG_NONE, MSG_INSERT, MSG_DELETE };
+            struct bufferMsg {
+                char op;
+                TID tid;
+            };
             uint keysPerInnerNode()const;
             uint keysPerLeafNode()const;
+            uint innerPivotSpace()const;
+            uint innerBufferOffset()const;
+            uint msgsPerBuffer()const;
+
+            //lesender Seitenzugriff, bei gemappter Datei ohne Buffermanager
+            const char * fixPageForRead(BlockNo b);
+            void unfixPageForRead();
+            void mapFile();
+            bool loadFile(size_t limit);
+            bool imageIsCurrent(const char * image);
+            void adviseInnerNodes();
+
+            void lookup(const DBAttrType & val,tidSink & sink);
+            void sharedLookup(const char * key,const DBAttrType & val,tidSink & sink);
+            void countChange();
+            void buildFilter();
+            void filterHashes(const char * key,uint & h1,uint & h2)const;
+            void filterAdd(uint h1,uint h2);
+            bool filterMayContain(const char * key)const;
+            bool filterExcludes(const char * key);
+            bool sharedFilterExcludes(const char * key);
+            void currentRoot(BlockNo & root,uint & depth);
+            BlockNo findInInnerNode(const DBAttrType & val, BlockNo b, bufferMsg * msg = NULL, bool * rightmost = NULL);
+            void findInLeafNode(const DBAttrType & val,BlockNo b,tidSink & sink);
 
-            BlockNo findInInnerNode(const DBAttrType & val, BlockNo b);
-            void findInLeafNode(const DBAttrType & val,BlockNo b,list<TID> & tids);
+            //komprimierte Blaetter (leafFormat != LEAF_PLAIN)
+            void codecKey(char * key)const;
+            uint encodeLeafEntry(char * out, const char * prevKey, const char * key, const TID * prevTid, const TID & tid)const;
+            void decodeLeaf(const char * page, vector<char> & image, uint reserve = 0)const;
+            const char * decodeLeafEntry(const char * ptr, char * prevKey, TID & prevTid)const;
+            bool findInFrontCodedLeaf(const char * page, const char * key, TID & tid)const;
+            bool encodeLeaf(const char * image, uint from, uint to, char * page)const;
+            bool encodePackedLeaf(const char * image, uint from, uint to, char * page)const;
+            void decodePackedLeaf(const char * page, vector<char> & image, uint reserve)const;
+            void findInPackedLeaf(const char * page, const DBAttrType & val, tidSink & sink)const;
+            uint leafSplitPos(const char * image)const;
+            splitInfo insertIntoCompressedLeaf(const BlockNo b, const DBAttrType &val, const TID &tid);
 
+            DBBACB fixNewPage(BlockNo near = 0);
+            DBBACB allocateExtent();
+            void releasePage(BlockNo b);
+            void loadSparePages();
+            void saveSparePages();
+            bool defragmentBatch(vector<char> & next, bool & first, BlockNo & prev, uint & moved);
+            BlockNo copyPath(const DBAttrType &val);
+            void commitCopy();
+            void reclaimPages();
+
+            int compareKeys(const char * a,const char * b)const;
+            const char * keyBytes(const DBAttrType & val);
+            string keyToString(const char * key)const;
+            uint leafVersionOffset()const;
+            void stampLeaf(char * page)const;
+            void startCursor(rangeCursor & cursor)const;
+            void loadRangeLeaf(rangeCursor & cursor)const;
+
+            static void * bulkSortWorker(void * arg);
+            static void * bulkMergeWorker(void * arg);
+            static void * bulkLeafWorker(void * arg);
+            bool balanceBulkLeaves(const char * image, vector<vector<char> > & pages, vector<size_t> & firstEntries, size_t right, size_t end) const;
+
+            void insertEntry(const DBAttrType &val, const TID &tid);
+            void removeEntry(const DBAttrType &val, const DBListTID &tid);
+            bool logChange(char op, const DBAttrType &val, const TID &tid);
+            void applySideLog(const vector<char> & log);
+            void insertIntoTree(const DBAttrType &val, const TID &tid);
+            void propagateSplit(pathStack & blocks, splitInfo splitResult);
             splitInfo insertIntoLeaf(const BlockNo b, const DBAttrType &val, const TID &tid);
-            splitInfo insertIntoInner(const BlockNo b, const DBAttrType &val, const BlockNo &newBlockNo);
+            splitInfo insertIntoInner(const BlockNo b, const char * key, const BlockNo &newBlockNo);
+            bool appendToRightmostLeaf(const DBAttrType &val, const TID &tid);
+            void rememberRightmostLeaf(BlockNo leaf);
+
+            void deliverMessage(const DBAttrType &val, char op, const TID &tid);
+            uint mergeIntoBuffer(const BlockNo b, const char * msgs, uint n);
+            void flushBuffer(const BlockNo b, uint height);
+            void applyBatch(const vector<char> & batch, uint height, BlockNo node);
+            void splitBuffer(char * leftPtr, char * rightPtr, const char * separator);
+            void applyToLeaf(const BlockNo b, const char * msgs, uint n);
+            BlockNo descendTo(const char * key, uint height, vector<char> & upper, pathStack * path = NULL);
+            void insertSeparator(const char * key, const BlockNo newBlockNo, uint height);
 
             bool removeFromLeafNode(const BlockNo b, const DBAttrType &val, const DBListTID &tid);
             bool rebalanceInnerNode(const BlockNo parentBlockNo, const BlockNo childBlockNo, bool childIsLeaf, bool parentIsRoot);
             void mergeInnerNodes(const BlockNo leftNode, const BlockNo rightNode, const DBAttrType &key);
             void mergeLeafNodes(const BlockNo leftNode, const BlockNo rightNode);
+            void removeRangeInNode(BlockNo b, uint height, const char * lo, const char * hi, const char * nodeLo, const char * nodeHi, uint & released);
+            void trimLeaf(BlockNo b, const char * lo, const char * hi);
+            void releaseSubtree(BlockNo b, uint height, uint & released);
+            void rebalancePath(const DBAttrType &val, uint & released);
+
+            //Suchkerne, je Schluesseltyp als Template instanziiert (feste Schrittweite, inline Vergleich)
+            typedef uint (*keySearch)(const char * entries, uint cnt, const char * key, uint keySize);
 
             static LoggerPtr logger;
             static const BlockNo metaBlockNo;
-            stack<DBBACB> bacbStack;
+            static const uint packedLeafMark;
+            static const uint filterBitsPerKey;
+            static const uint filterHashCnt;
+            static const uint extentSize;
+            static const uint catchUpRounds;
+            static const uint catchUpEntries;
+            stack<DBBACB,vector<DBBACB> > bacbStack;
+            opArena arena;
+            vector<char> leafImage;
+            vector<char> leafScratch;
+            keySearch innerSearch;
+            keySearch leafSearch;
+            //Append-Pfad: rechtestes Blatt, sein Versionsstempel und seine untere Grenze (0 = unbekannt)
+            BlockNo appendLeaf;
+            uint appendStamp;
+            bool appendFenced;
+            vector<char> appendFence;
+            bool buffered;
+            enum LeafFormat leafFormat;
+            const char * mappedPtr;
+            bool copyOnWrite;
+            uint epoch;
+            //freie Seiten (Rest angelegter Extents, wiederverwendete Seiten), nach dem ersten
+            //schreibenden Zugriff nur im Hauptspeicher, beim Schliessen wieder als Freiliste
+            set<BlockNo> sparePages;
+            bool spareLoaded;
+            uint releaseCount; //freigegebene Seiten, Cursor auf ihnen steigen neu ab
+            bool changed; //Handle hat geaendert, setzt beim Schliessen die Marke im Metablock
+            vector<pair<uint,BlockNo> > retired;
+            map<uint,uint> pinned; //Epoche -> Anzahl aktiver Snapshots
+            size_t mappedLen;
+            size_t residentLen; //Groesse des geladenen Bereichs, 0 = Datei gemappt
+            bool shared;
+            mutable pthread_rwlock_t latch;
+            BlockNo sharedRoot;
+            uint sharedDepth;
+            //Bloom-Filter (filtered mode), nur im Hauptspeicher; filterBits == 0: kein Filter
+            vector<unsigned char> filter;
+            uint filterBits;
+            uint filterKeys;
+            uint filterCapacity;
+            uint filterStamp; //Aenderungszaehler des Metablocks beim letzten Abgleich
+            //Praedikat des partiellen Index, steht im Metablock
+            bool partial;
+            string predicate;
+            //Online-Aufbau: Nebenprotokoll, geschuetzt durch buildLock
+            bool building;
+            bool buildFailed; //Aufbau abgebrochen, Index muss neu angelegt werden
+            pthread_mutex_t buildLock;
+            vector<char> sideLog;
 
         };
     }
@@ -0,0 +1,69 @@
+#ifndef HUBDB_DBTIDBITMAP_H
+#define HUBDB_DBTIDBITMAP_H
+
+#include <hubDB/DBIndex.h>
+
+namespace HubDB{
+    namespace Index{
+        /**
+         * TID-Menge fuer Bitmap-Index-Scans (AND/OR mehrerer Indexe)
+         * - nach Seite (TID.page) geordnet, pro Seite ein Container der Slots
+         * - Container: sortiertes Slot-Array oder Bitmap aus 64-Bit-Woertern,
+         *   je nachdem, was weniger Platz braucht (wie bei Roaring-Bitmaps)
+         * - AND/OR/ANDNOT arbeiten wortweise auf Bitmaps und mischend auf Arrays
+         * - forEachPage() liefert die Seiten in physischer Reihenfolge, damit
+         *   jede Heapseite beim Nachladen nur einmal fixiert werden muss
+         */
+        class DBTidBitmap{
+
+        public:
+            //Heap-Zugriff: visit() je Seite mit aufsteigenden Slots, false bricht ab
+            class pageVisitor {
+            public:
+                virtual ~pageVisitor(){};
+                virtual bool visit(BlockNo page,const uint * slots,uint cnt) = 0;
+            };
+
+            DBTidBitmap();
+            string toString(string linePrefix="") const;
+
+            void add(const TID & tid);
+            bool contains(const TID & tid)const;
+            size_t size()const{ return cnt;};
+            bool empty()const{ return cnt == 0;};
+            uint pageCnt()const{ return pages.size();};
+            void clear();
+
+            void andWith(const DBTidBitmap & other);
+            void orWith(const DBTidBitmap & other);
+            void andNotWith(const DBTidBitmap & other);
+
+            void forEachPage(pageVisitor & visitor)const;
+            void toList(DBListTID & tids)const;
+
+        private:
+            typedef unsigned long long word;
+            struct slotSet {
+                slotSet():cnt(0){};
+                vector<uint> slots; //Array-Container, sortiert; leer bei Bitmap-Container
+                vector<word> words; //Bitmap-Container, Slot s ist Bit s % 64 in Wort s / 64
+                uint cnt;
+            };
+            typedef map<BlockNo,slotSet> pageMap;
+
+            static void toBitmap(slotSet & set);
+            static void toArray(slotSet & set);
+            static void optimize(slotSet & set);
+            static void andSets(slotSet & set,const slotSet & other);
+            static void orSets(slotSet & set,const slotSet & other);
+            static void andNotSets(slotSet & set,const slotSet & other);
+            static void slotsOf(const slotSet & set,vector<uint> & slots);
+
+            static LoggerPtr logger;
+            pageMap pages;
+            size_t cnt;
+        };
+    }
+}
+
+#endif //HUBDB_DBTIDBITMAP_H